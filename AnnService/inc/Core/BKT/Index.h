@@ -13,6 +13,7 @@
 #include "inc/Core/Common/Dataset.h"
 #include "inc/Core/Common/WorkSpace.h"
 #include "inc/Core/Common/WorkSpacePool.h"
+#include "inc/Core/Common/TerminationPolicy.h"
 #include "inc/Core/Common/RelativeNeighborhoodGraph.h"
 #include "inc/Core/Common/BKTree.h"
 #include "inc/Core/Common/Labelset.h"
@@ -51,6 +52,17 @@ namespace SPTAG
                 DistCalcMethod m_distMethod;
             };
 
+            // Read-only copy of the search structures, allocated on one NUMA node.
+            struct NumaReplica
+            {
+                COMMON::Dataset<T> m_pSamples;
+                COMMON::BKTree m_pTrees;
+                COMMON::RelativeNeighborhoodGraph m_pGraph;
+
+                NumaReplica(const COMMON::BKTree& p_trees) : m_pTrees(p_trees) {}
+            };
+            typedef std::vector<std::unique_ptr<NumaReplica>> NumaReplicaSet;
+
         private:
             // data points
             COMMON::Dataset<T> m_pSamples;
@@ -72,12 +84,18 @@ namespace SPTAG
             std::shared_timed_mutex m_dataDeleteLock;
             COMMON::Labelset m_deletedID;
 
+            // One replica per NUMA node when NumaMode is 2. AddIndex only updates the originals, so it drops them.
+            std::shared_ptr<NumaReplicaSet> m_pNumaReplicas;
+
             std::unique_ptr<COMMON::WorkSpacePool<COMMON::WorkSpace>> m_workSpacePool;
             Helper::ThreadPool m_threadPool;
             int m_iNumberOfThreads;
 
             DistCalcMethod m_iDistCalcMethod;
+            bool m_bMIPSTransform;
+            bool m_bGraphReorder;
             std::function<float(const T*, const T*, DimensionType)> m_fComputeDistance;
+            COMMON::DistanceBatchCalcReturn<T> m_fComputeDistanceBatch;
             int m_iBaseSquare;
 
             int m_iMaxCheck;        
@@ -85,6 +103,12 @@ namespace SPTAG
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
             int m_iHashTableExp;
+            int m_iHeapArity;
+            int m_iHugePages;
+            int m_iNumaMode;
+            int m_iBatchSearchSize;
+
+            template <typename U> friend class Index;
 
         public:
             Index()
@@ -97,6 +121,7 @@ namespace SPTAG
 
                 m_pSamples.SetName("Vector");
                 m_fComputeDistance = std::function<float(const T*, const T*, DimensionType)>(COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod));
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod);
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             }
 
@@ -114,7 +139,7 @@ namespace SPTAG
             void SetQuantizer(std::shared_ptr<SPTAG::COMMON::IQuantizer> quantizer);
             
             inline float AccurateDistance(const void* pX, const void* pY) const { 
-                if (m_iDistCalcMethod == DistCalcMethod::L2) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                if (m_iDistCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
 
                 float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
                 float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
@@ -122,9 +147,13 @@ namespace SPTAG
                 return 1.0f - xy / (sqrt(xx) * sqrt(yy));
             }
             inline float ComputeDistance(const void* pX, const void* pY) const { return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C()); }
+            inline void ComputeDistanceBatch(const void* pX, const SizeType* pIDs, int count, float* pDist) const
+            {
+                ComputeDistanceBatch(m_pSamples, pX, pIDs, count, pDist);
+            }
             inline const void* GetSample(const SizeType idx) const { return (void*)m_pSamples[idx]; }
             inline bool ContainSample(const SizeType idx) const { return idx >= 0 && idx < m_deletedID.R() && !m_deletedID.Contains(idx); }
-            inline bool NeedRefine() const { return m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
+            inline bool NeedRefine() const { return m_bGraphReorder || m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
             std::shared_ptr<std::vector<std::uint64_t>> BufferSize() const
             {
                 std::shared_ptr<std::vector<std::uint64_t>> buffersize(new std::vector<std::uint64_t>);
@@ -154,6 +183,8 @@ namespace SPTAG
 
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, bool p_normalized = false, bool p_shareOwnership = false);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const;
+            ErrorCode SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta = false, bool p_searchDeleted = false) const;
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
             ErrorCode SearchTree(QueryResult &p_query) const;
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false);
@@ -168,7 +199,66 @@ namespace SPTAG
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
 
         private:
+            inline void SelectDistanceFunction()
+            {
+                if (m_pQuantizer)
+                {
+                    m_fComputeDistance = m_pQuantizer->DistanceCalcSelector<T>(m_iDistCalcMethod);
+                    m_fComputeDistanceBatch = nullptr;
+                }
+                else
+                {
+                    m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod, m_pSamples.C());
+                    m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod, m_pSamples.C());
+                }
+            }
+
+            // Back the sample, graph and deleted ID storage allocated from now on with huge pages.
+            inline void SelectHugePages()
+            {
+                Helper::HugePageMode mode = (Helper::HugePageMode)m_iHugePages;
+                m_pSamples.SetHugePages(mode);
+                m_pGraph.SetHugePages(mode);
+                m_deletedID.SetHugePages(mode);
+            }
+
+            inline void ComputeDistanceBatch(const COMMON::Dataset<T>& samples, const void* pX, const SizeType* pIDs, int count, float* pDist) const
+            {
+                if (m_fComputeDistanceBatch == nullptr)
+                {
+                    for (int i = 0; i < count; i++) pDist[i] = m_fComputeDistance((const T*)pX, samples[pIDs[i]], samples.C());
+                    return;
+                }
+
+                const T* rows[64];
+                for (int begin = 0; begin < count; begin += 64)
+                {
+                    int num = min(count - begin, 64);
+                    for (int i = 0; i < num; i++) rows[i] = samples[pIDs[begin + i]];
+                    m_fComputeDistanceBatch((const T*)pX, rows, num, samples.C(), pDist + begin);
+                }
+            }
+
+            // Replica on the NUMA node of the calling thread, or nullptr to search the originals.
+            inline const NumaReplica* LocalReplica(const std::shared_ptr<NumaReplicaSet>& replicas) const
+            {
+                if (replicas == nullptr) return nullptr;
+                return (*replicas)[Helper::Numa::CurrentNode() % replicas->size()].get();
+            }
+
+            // Applies NumaMode: interleaves the originals over all nodes (1) or rebuilds the per node replicas (2).
+            void PlaceOnNuma();
+
+            ErrorCode BuildMIPSStructures();
+            // Fills indices (new -> old) and reverseIndices (old -> new) for a refine, dropping deleted vectors.
+            SizeType GetRefineOrder(std::vector<SizeType>& indices, std::vector<SizeType>& reverseIndices) const;
+
             void SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated) const;
+            void SearchIndexBatch(std::vector<COMMON::QueryResultSet<T>*>& p_queries, std::vector<COMMON::WorkSpace*>& p_spaces, bool p_searchDeleted) const;
+            // Scores every vector accepted by the filter; used when it accepts fewer vectors than MaxCheck.
+            void SearchIndexByFilter(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, const IFilter& p_filter, bool p_searchDeleted) const;
+            // Graph search bounded by the radius rather than by the k-th result; appends to p_results unsorted.
+            void SearchIndexRange(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_searchDeleted) const;
         };
     } // namespace BKT
 } // namespace SPTAG
@@ -39,14 +39,20 @@ DefineBKTParameter(m_pGraph.m_iTPTBalanceFactor, int, 2, "TPTBalanceFactor")
 
 DefineBKTParameter(m_iNumberOfThreads, int, 1L, "NumberOfThreads")
 DefineBKTParameter(m_iDistCalcMethod, SPTAG::DistCalcMethod, SPTAG::DistCalcMethod::Cosine, "DistCalcMethod")
+DefineBKTParameter(m_bMIPSTransform, bool, true, "MIPSTransform") // Build InnerProduct indexes in the augmented L2 space
 
 DefineBKTParameter(m_fDeletePercentageForRefine, float, 0.4F, "DeletePercentageForRefine")
 DefineBKTParameter(m_addCountForRebuild, int, 1000, "AddCountForRebuild")
+DefineBKTParameter(m_bGraphReorder, bool, false, "GraphReorder") // Renumber vectors breadth first over the graph whenever the index is refined or saved
 DefineBKTParameter(m_iMaxCheck, int, 8192L, "MaxCheck")
 DefineBKTParameter(m_iThresholdOfNumberOfContinuousNoBetterPropagation, int, 3L, "ThresholdOfNumberOfContinuousNoBetterPropagation")
 DefineBKTParameter(m_iNumberOfInitialDynamicPivots, int, 50L, "NumberOfInitialDynamicPivots")
 DefineBKTParameter(m_iNumberOfOtherDynamicPivots, int, 4L, "NumberOfOtherDynamicPivots")
 DefineBKTParameter(m_iHashTableExp, int, 2L, "HashTableExponent")
+DefineBKTParameter(m_iHugePages, int, 0L, "HugePages") // 0: regular pages, 1: 2 MB pages, 2: 1 GB pages; falls back when unavailable
+DefineBKTParameter(m_iNumaMode, int, 0L, "NumaMode") // 0: first touch, 1: interleave over all nodes, 2: read-only copy per node
+DefineBKTParameter(m_iHeapArity, int, 2L, "HeapArity") // Fan-out of the graph and tree search queues: 2, 4 or 8
+DefineBKTParameter(m_iBatchSearchSize, int, 1L, "BatchSearchSize") // Number of queries walked through the graph together in batch search
 DefineBKTParameter(m_iDataBlockSize, int, 1024 * 1024, "DataBlockSize")
 DefineBKTParameter(m_iDataCapacity, int, MaxSize, "DataCapacity")
 DefineBKTParameter(m_iMetaRecordSize, int, 10, "MetaRecordSize")
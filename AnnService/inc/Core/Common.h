@@ -14,6 +14,7 @@
 #include <cmath>
 #include "inc/Helper/Logging.h"
 #include "inc/Helper/DiskIO.h"
+#include "inc/Core/Float16.h"
 
 #ifndef _MSC_VER
 #include <stdio.h>
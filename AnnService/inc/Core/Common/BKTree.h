@@ -57,12 +57,12 @@ namespace SPTAG
                     _RD = m_pQuantizer->ReconstructDim();
                     fComputeDistance = m_pQuantizer->DistanceCalcSelector<T>(distMethod);
                 }
-                else if (distMethod == DistCalcMethod::L2 || distMethod == DistCalcMethod::Cosine)
+                else if (distMethod == DistCalcMethod::L2 || distMethod == DistCalcMethod::Cosine || distMethod == DistCalcMethod::InnerProduct)
                 {
-                    fComputeDistance = COMMON::DistanceCalcSelector<T>(DistCalcMethod::L2);
+                    fComputeDistance = COMMON::DistanceCalcSelector<T>(DistCalcMethod::L2, dim);
                 }
                 else {
-                    fComputeDistance = COMMON::DistanceCalcSelector<T>(distMethod);
+                    fComputeDistance = COMMON::DistanceCalcSelector<T>(distMethod, dim);
                 }
 
                 centers = (T*)ALIGN_ALLOC(sizeof(T) * _K * _D);
@@ -528,6 +528,13 @@ break;
 
             inline const std::unordered_map<SizeType, SizeType>& GetSampleMap() const { return m_pSampleCenterMap; }
 
+            // Copies the tree nodes into p_other for search; the sample to center map is left out.
+            inline void CopyTo(BKTree& p_other) const
+            {
+                p_other.m_pTreeStart = m_pTreeStart;
+                p_other.m_pTreeRoots = m_pTreeRoots;
+            }
+
             template <typename T>
             void Rebuild(const Dataset<T>& data, DistCalcMethod distMethod, IAbortOperation* abort)
             {
@@ -540,6 +547,15 @@ break;
                 m_pSampleCenterMap.swap(newTrees.m_pSampleCenterMap);
             }
 
+            // Take over the trees built by another index over the same rows.
+            void Swap(BKTree& other)
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(*m_lock);
+                m_pTreeRoots.swap(other.m_pTreeRoots);
+                m_pTreeStart.swap(other.m_pTreeStart);
+                m_pSampleCenterMap.swap(other.m_pSampleCenterMap);
+            }
+
             template <typename T>
             void BuildTrees(const Dataset<T>& data, DistCalcMethod distMethod, int numOfThreads, 
                 std::vector<SizeType>* indices = nullptr, std::vector<SizeType>* reverseIndices = nullptr, 
@@ -52,7 +52,8 @@ namespace SPTAG
 
             template<typename T>
             static inline int GetBase() {
-                if (GetEnumValueType<T>() != VectorValueType::Float) {
+                VectorValueType type = GetEnumValueType<T>();
+                if (type != VectorValueType::Float && type != VectorValueType::Float16 && type != VectorValueType::BFloat16) {
                     return (int)(std::numeric_limits<T>::max)();
                 }
                 return 1;
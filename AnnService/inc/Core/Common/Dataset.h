@@ -4,6 +4,9 @@
 #ifndef _SPTAG_COMMON_DATASET_H_
 #define _SPTAG_COMMON_DATASET_H_
 
+#include "inc/Helper/HugePageAllocator.h"
+#include "inc/Helper/Numa.h"
+
 namespace SPTAG
 {
     namespace COMMON
@@ -23,6 +26,24 @@ namespace SPTAG
             SizeType rowsInBlock;
             SizeType rowsInBlockEx;
             std::vector<T*> incBlocks;
+            Helper::HugePageMode hugePages = Helper::HugePageMode::None;
+            // Mapped length of each huge page allocation, 0 for ALIGN_ALLOC memory.
+            std::size_t dataAllocated = 0;
+            std::vector<std::size_t> incAllocated;
+
+            T* Allocate(std::size_t bytes, std::size_t& allocated)
+            {
+                T* ptr = (T*)Helper::HugePageAlloc(bytes, hugePages, allocated);
+                if (ptr != nullptr) return ptr;
+                allocated = 0;
+                return (T*)ALIGN_ALLOC(bytes);
+            }
+
+            void Free(T* ptr, std::size_t allocated)
+            {
+                if (allocated > 0) Helper::HugePageFree(ptr, allocated);
+                else ALIGN_FREE(ptr);
+            }
 
         public:
             Dataset() {}
@@ -33,9 +54,10 @@ namespace SPTAG
             }
             ~Dataset()
             {
-                if (ownData) ALIGN_FREE(data);
-                for (T* ptr : incBlocks) ALIGN_FREE(ptr);
+                if (ownData) Free(data, dataAllocated);
+                for (size_t i = 0; i < incBlocks.size(); i++) Free(incBlocks[i], incAllocated[i]);
                 incBlocks.clear();
+                incAllocated.clear();
             }
             void Initialize(SizeType rows_, DimensionType cols_, SizeType rowsInBlock_, SizeType capacity_, T* data_ = nullptr, bool shareOwnership_ = true)
             {
@@ -45,7 +67,7 @@ namespace SPTAG
                 if (data_ == nullptr || !shareOwnership_)
                 {
                     ownData = true;
-                    data = (T*)ALIGN_ALLOC(((size_t)rows) * cols * sizeof(T));
+                    data = Allocate(((size_t)rows) * cols * sizeof(T), dataAllocated);
                     if (data_ != nullptr) memcpy(data, data_, ((size_t)rows) * cols * sizeof(T));
                     else std::memset(data, -1, ((size_t)rows) * cols * sizeof(T));
                 }
@@ -54,8 +76,20 @@ namespace SPTAG
                 rowsInBlock = (1 << rowsInBlockEx) - 1;
                 incBlocks.reserve((static_cast<std::int64_t>(capacity_) + rowsInBlock) >> rowsInBlockEx);
             }
+            // Takes effect for allocations made after the call; set it before Initialize or Load.
+            void SetHugePages(Helper::HugePageMode hugePages_) { hugePages = hugePages_; }
             void SetName(const std::string& name_) { name = name_; }
             const std::string& Name() const { return name; }
+            // Moves the rows allocated so far to NUMA node node_, or spreads them over all nodes when node_ < 0.
+            bool PlaceOnNuma(int node_) const
+            {
+                auto place = [node_](T* ptr, std::size_t bytes) {
+                    return (node_ < 0) ? Helper::Numa::Interleave(ptr, bytes) : Helper::Numa::Bind(ptr, bytes, node_);
+                };
+                bool placed = (data == nullptr || place(data, ((size_t)rows) * cols * sizeof(T)));
+                for (T* ptr : incBlocks) placed = place(ptr, ((size_t)rowsInBlock + 1) * cols * sizeof(T)) && placed;
+                return placed;
+            }
 
             void SetR(SizeType R_)
             {
@@ -98,9 +132,11 @@ namespace SPTAG
                 while (written < num) {
                     SizeType curBlockIdx = ((incRows + written) >> rowsInBlockEx);
                     if (curBlockIdx >= (SizeType)incBlocks.size()) {
-                        T* newBlock = (T*)ALIGN_ALLOC(((size_t)rowsInBlock + 1) * cols * sizeof(T));
+                        std::size_t allocated;
+                        T* newBlock = Allocate(((size_t)rowsInBlock + 1) * cols * sizeof(T), allocated);
                         if (newBlock == nullptr) return ErrorCode::MemoryOverFlow;
                         incBlocks.push_back(newBlock);
+                        incAllocated.push_back(allocated);
                     }
                     SizeType curBlockPos = ((incRows + written) & rowsInBlock);
                     SizeType toWrite = min(rowsInBlock + 1 - curBlockPos, num - written);
@@ -119,10 +155,12 @@ namespace SPTAG
                 while (written < num) {
                     SizeType curBlockIdx = (incRows + written) >> rowsInBlockEx;
                     if (curBlockIdx >= (SizeType)incBlocks.size()) {
-                        T* newBlock = (T*)ALIGN_ALLOC(sizeof(T) * (rowsInBlock + 1) * cols);
+                        std::size_t allocated;
+                        T* newBlock = Allocate(sizeof(T) * (rowsInBlock + 1) * cols, allocated);
                         if (newBlock == nullptr) return ErrorCode::MemoryOverFlow;
                         std::memset(newBlock, -1, sizeof(T) * (rowsInBlock + 1) * cols);
                         incBlocks.push_back(newBlock);
+                        incAllocated.push_back(allocated);
                     }
                     written += min(rowsInBlock + 1 - ((incRows + written) & rowsInBlock), num - written);
                 }
@@ -193,7 +231,7 @@ namespace SPTAG
             ErrorCode Refine(const std::vector<SizeType>& indices, Dataset<T>& data) const
             {
                 SizeType R = (SizeType)(indices.size());
-                data.Initialize(R, cols, rowsInBlock + 1, static_cast<SizeType>(incBlocks.capacity() * (rowsInBlock + 1)));
+                data.Initialize(R, cols, rowsInBlock + 1, maxRows);
                 for (SizeType i = 0; i < R; i++) {
                     std::memcpy((void*)data.At(i), (void*)this->At(indices[i]), sizeof(T) * cols);
                 }
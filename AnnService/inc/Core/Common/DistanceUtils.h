@@ -20,6 +20,16 @@ namespace SPTAG
         template<typename T>
         inline DistanceCalcReturn<T> DistanceCalcSelector(SPTAG::DistCalcMethod p_method);
 
+        template <typename T>
+        using DistanceBatchCalcReturn = void(*)(const T*, const T* const*, int, DimensionType, float*);
+        template<typename T>
+        inline DistanceBatchCalcReturn<T> DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method);
+
+        template<typename T>
+        inline DistanceCalcReturn<T> DistanceCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension);
+        template<typename T>
+        inline DistanceBatchCalcReturn<T> DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension);
+
         class DistanceUtils
         {
         public:
@@ -59,6 +69,45 @@ namespace SPTAG
             static float ComputeL2Distance_AVX(const float* pX, const float* pY, DimensionType length);
             static float ComputeL2Distance_AVX512(const float* pX, const float* pY, DimensionType length);
 
+            static float ComputeL2Distance_SSE(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const Float16* pX, const Float16* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+
+            // One-to-many variants: score pX against each of the count rows in pY.
+            template <typename T>
+            static void ComputeL2DistanceBatch(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+            {
+                for (int i = 0; i < count; i++) pDist[i] = ComputeL2Distance(pX, pY[i], length);
+            }
+
+            static void ComputeL2DistanceBatch_SSE(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeL2DistanceBatch_SSE(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeL2DistanceBatch_SSE(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeL2DistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeL2DistanceBatch_SSE(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeL2DistanceBatch_SSE(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+
             template <typename T>
             static float ComputeCosineDistance(const T* pX, const T* pY, DimensionType length)
             {
@@ -95,6 +144,150 @@ namespace SPTAG
             static float ComputeCosineDistance_AVX(const float* pX, const float* pY, DimensionType length);
             static float ComputeCosineDistance_AVX512(const float* pX, const float* pY, DimensionType length);
 
+            static float ComputeCosineDistance_SSE(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const Float16* pX, const Float16* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+
+            template <typename T>
+            static void ComputeCosineDistanceBatch(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+            {
+                for (int i = 0; i < count; i++) pDist[i] = ComputeCosineDistance(pX, pY[i], length);
+            }
+
+            static void ComputeCosineDistanceBatch_SSE(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeCosineDistanceBatch_SSE(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeCosineDistanceBatch_SSE(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeCosineDistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeCosineDistanceBatch_SSE(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeCosineDistanceBatch_SSE(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+
+            template <typename T>
+            static float ComputeInnerProductDistance(const T* pX, const T* pY, DimensionType length)
+            {
+                const T* pEnd4 = pX + ((length >> 2) << 2);
+                const T* pEnd1 = pX + length;
+
+                float diff = 0;
+
+                while (pX < pEnd4)
+                {
+                    float c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
+                }
+                while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
+                return -diff;
+            }
+
+            static float ComputeInnerProductDistance_SSE(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+
+            static float ComputeInnerProductDistance_SSE(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+
+            static float ComputeInnerProductDistance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+
+            static float ComputeInnerProductDistance_SSE(const float* pX, const float* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const float* pX, const float* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const float* pX, const float* pY, DimensionType length);
+
+            static float ComputeInnerProductDistance_SSE(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const Float16* pX, const Float16* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const Float16* pX, const Float16* pY, DimensionType length);
+
+            static float ComputeInnerProductDistance_SSE(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+            static float ComputeInnerProductDistance_AVX512(const BFloat16* pX, const BFloat16* pY, DimensionType length);
+
+            template <typename T>
+            static void ComputeInnerProductDistanceBatch(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+            {
+                for (int i = 0; i < count; i++) pDist[i] = ComputeInnerProductDistance(pX, pY[i], length);
+            }
+
+            static void ComputeInnerProductDistanceBatch_SSE(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeInnerProductDistanceBatch_SSE(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeInnerProductDistanceBatch_SSE(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const std::int16_t* pX, const std::int16_t* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeInnerProductDistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeInnerProductDistanceBatch_SSE(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const Float16* pX, const Float16* const* pY, int count, DimensionType length, float* pDist);
+
+            static void ComputeInnerProductDistanceBatch_SSE(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeInnerProductDistanceBatch_AVX512(const BFloat16* pX, const BFloat16* const* pY, int count, DimensionType length, float* pDist);
+
+            // int8/uint8 kernels built on vpdpbusd (AVX512-VNNI and AVX-VNNI).
+            static float ComputeL2Distance_AVX512VNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512VNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVXVNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVXVNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVXVNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVXVNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+
+            static void ComputeL2DistanceBatch_AVX512VNNI(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512VNNI(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVXVNNI(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeL2DistanceBatch_AVXVNNI(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVXVNNI(const std::int8_t* pX, const std::int8_t* const* pY, int count, DimensionType length, float* pDist);
+            static void ComputeCosineDistanceBatch_AVXVNNI(const std::uint8_t* pX, const std::uint8_t* const* pY, int count, DimensionType length, float* pDist);
+
+            // Return the VNNI L2/Cosine kernels for int8/uint8 when the CPU and compiler support them, nullptr otherwise.
+            template <typename T>
+            static DistanceCalcReturn<T> VNNICalcSelector(SPTAG::DistCalcMethod p_method);
+
+            template <typename T>
+            static DistanceBatchCalcReturn<T> VNNIBatchCalcSelector(SPTAG::DistCalcMethod p_method);
+
+
+            // L2/Cosine kernels unrolled for D = 64, 96, 128, 256 and 768 on AVX2/AVX512. Return nullptr for any other dimension or method.
+            template <typename T>
+            static DistanceCalcReturn<T> FixedDimensionCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension);
+
+            template <typename T>
+            static DistanceBatchCalcReturn<T> FixedDimensionBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension);
 
             template<typename T>
             static inline float ComputeDistance(const T* p1, const T* p2, DimensionType length, SPTAG::DistCalcMethod distCalcMethod)
@@ -119,10 +312,32 @@ namespace SPTAG
         template<typename T>
         inline DistanceCalcReturn<T> DistanceCalcSelector(SPTAG::DistCalcMethod p_method)
         {
+            if (InstructionSet::AVX512VNNI() || InstructionSet::AVXVNNI())
+            {
+                DistanceCalcReturn<T> func = DistanceUtils::VNNICalcSelector<T>(p_method);
+                if (func != nullptr) return func;
+            }
+
             bool isSize4 = (sizeof(T) == 4);
             switch (p_method)
             {
             case SPTAG::DistCalcMethod::InnerProduct:
+                if (InstructionSet::AVX512())
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistance_AVX512);
+                }
+                else if (InstructionSet::AVX2() || (isSize4 && InstructionSet::AVX()))
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistance_AVX);
+                }
+                else if (InstructionSet::SSE2() || (isSize4 && InstructionSet::SSE()))
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistance_SSE);
+                }
+                else {
+                    return &(DistanceUtils::ComputeInnerProductDistance);
+                }
+
             case SPTAG::DistCalcMethod::Cosine:
                 if (InstructionSet::AVX512())
                 {
@@ -162,6 +377,89 @@ namespace SPTAG
             }
             return nullptr;
         }
+
+        template<typename T>
+        inline DistanceBatchCalcReturn<T> DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method)
+        {
+            if (InstructionSet::AVX512VNNI() || InstructionSet::AVXVNNI())
+            {
+                DistanceBatchCalcReturn<T> func = DistanceUtils::VNNIBatchCalcSelector<T>(p_method);
+                if (func != nullptr) return func;
+            }
+
+            bool isSize4 = (sizeof(T) == 4);
+            switch (p_method)
+            {
+            case SPTAG::DistCalcMethod::InnerProduct:
+                if (InstructionSet::AVX512())
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistanceBatch_AVX512);
+                }
+                else if (InstructionSet::AVX2() || (isSize4 && InstructionSet::AVX()))
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistanceBatch_AVX);
+                }
+                else if (InstructionSet::SSE2() || (isSize4 && InstructionSet::SSE()))
+                {
+                    return &(DistanceUtils::ComputeInnerProductDistanceBatch_SSE);
+                }
+                else {
+                    return &(DistanceUtils::ComputeInnerProductDistanceBatch);
+                }
+
+            case SPTAG::DistCalcMethod::Cosine:
+                if (InstructionSet::AVX512())
+                {
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_AVX512);
+                }
+                else if (InstructionSet::AVX2() || (isSize4 && InstructionSet::AVX()))
+                {
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_AVX);
+                }
+                else if (InstructionSet::SSE2() || (isSize4 && InstructionSet::SSE()))
+                {
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_SSE);
+                }
+                else {
+                    return &(DistanceUtils::ComputeCosineDistanceBatch);
+                }
+
+            case SPTAG::DistCalcMethod::L2:
+                if (InstructionSet::AVX512())
+                {
+                    return &(DistanceUtils::ComputeL2DistanceBatch_AVX512);
+                }
+                else if (InstructionSet::AVX2() || (isSize4 && InstructionSet::AVX()))
+                {
+                    return &(DistanceUtils::ComputeL2DistanceBatch_AVX);
+                }
+                else if (InstructionSet::SSE2() || (isSize4 && InstructionSet::SSE()))
+                {
+                    return &(DistanceUtils::ComputeL2DistanceBatch_SSE);
+                }
+                else {
+                    return &(DistanceUtils::ComputeL2DistanceBatch);
+                }
+
+            default:
+                break;
+            }
+            return nullptr;
+        }
+
+        template<typename T>
+        inline DistanceCalcReturn<T> DistanceCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)
+        {
+            DistanceCalcReturn<T> func = DistanceUtils::FixedDimensionCalcSelector<T>(p_method, p_dimension);
+            return (func != nullptr) ? func : DistanceCalcSelector<T>(p_method);
+        }
+
+        template<typename T>
+        inline DistanceBatchCalcReturn<T> DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)
+        {
+            DistanceBatchCalcReturn<T> func = DistanceUtils::FixedDimensionBatchCalcSelector<T>(p_method, p_dimension);
+            return (func != nullptr) ? func : DistanceBatchCalcSelector<T>(p_method);
+        }
     }
 }
 
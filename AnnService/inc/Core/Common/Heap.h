@@ -10,24 +10,35 @@ namespace SPTAG
     {
 
         // priority queue
+        // The fan-out is 2, 4 or 8: wider heaps are shallower and scan siblings that share a cache line,
+        // trading a few more comparisons per level for fewer levels in insert and pop.
         template <typename T>
         class Heap {
         public:
-            Heap() : heap(nullptr), length(0), count(0) {}
+            Heap() : heap(nullptr), length(0), count(0), arity(2) {}
 
-            Heap(int size) { Resize(size); }
+            Heap(int size, int arity = 2) { Resize(size, arity); }
 
-            void Resize(int size)
+            void Resize(int size, int arity = 2)
             {
                 length = size;
                 heap.reset(new T[length + 1]);  // heap uses 1-based indexing
                 count = 0;
-                lastlevel = int(pow(2.0, floor(log2((float)size))));
+                this->arity = (arity == 4 || arity == 8) ? arity : 2;
+
+                // First position of the deepest level.
+                int first = 0, width = 1;
+                while (first + width < size) {
+                    first += width;
+                    width *= this->arity;
+                }
+                lastlevel = first + 1;
             }
             ~Heap() {}
             inline int size() { return count; }
             inline bool empty() { return count == 0; }
             inline void clear() { count = 0; }
+            inline int Arity() const { return arity; }
             inline T& Top() { if (count == 0) return heap[0]; else return heap[1]; }
 
             // Insert a new element in the heap.
@@ -45,15 +56,11 @@ namespace SPTAG
                 else {
                     loc = ++(count);   /* Remember 1-based indexing. */
                 }
-                /* Keep moving parents down until a place is found for this node. */
-                int par = (loc >> 1);                 /* Location of parent. */
-                while (par > 0 && value < heap[par]) {
-                    heap[loc] = heap[par];     /* Move parent down to loc. */
-                    loc = par;
-                    par >>= 1;
+                switch (arity) {
+                case 4: siftUp<4>(loc, value); break;
+                case 8: siftUp<8>(loc, value); break;
+                default: siftUp<2>(loc, value); break;
                 }
-                /* Insert the element at the determined location. */
-                heap[loc] = value;
             }
             // Returns the node of minimum value from the heap (top of the heap).
             bool pop(T& value)
@@ -82,21 +89,50 @@ namespace SPTAG
             int length;
             int count; // Number of element in the heap
             int lastlevel;
+            int arity; // Number of children per node
+
+            // Children of node i are D * (i - 1) + 2 ... D * (i - 1) + D + 1, so D = 2 gives the usual 2i, 2i + 1.
+            template <int D>
+            inline void siftUp(int loc, const T& value)
+            {
+                /* Keep moving parents down until a place is found for this node. */
+                while (loc > 1) {
+                    int par = (loc - 2) / D + 1;      /* Location of parent. */
+                    if (!(value < heap[par])) break;
+                    heap[loc] = heap[par];     /* Move parent down to loc. */
+                    loc = par;
+                }
+                /* Insert the element at the determined location. */
+                heap[loc] = value;
+            }
+
             // Reorganizes the heap (a parent is smaller than its children) starting with a node.
+            template <int D>
+            inline void siftDown()
+            {
+                if (count <= 1) return;
+                T value = heap[1];
+                int parent = 1;
+                while (true) {
+                    int next = D * (parent - 1) + 2;
+                    if (next > count) break;
+                    int last = min(next + D - 1, count);
+                    for (int i = next + 1; i <= last; i++)
+                        if (heap[i] < heap[next]) next = i;
+                    if (!(heap[next] < value)) break;
+                    heap[parent] = heap[next];
+                    parent = next;
+                }
+                heap[parent] = value;
+            }
 
             void heapify()
             {
-                int parent = 1, next = 2;
-                while (next < count) {
-                    if (heap[next] > heap[next + 1]) next++;
-                    if (heap[next] < heap[parent]) {
-                        std::swap(heap[parent], heap[next]);
-                        parent = next;
-                        next <<= 1;
-                    }
-                    else break;
+                switch (arity) {
+                case 4: siftDown<4>(); break;
+                case 8: siftDown<8>(); break;
+                default: siftDown<2>(); break;
                 }
-                if (next == count && heap[next] < heap[parent]) std::swap(heap[parent], heap[next]);
             }
         };
     }
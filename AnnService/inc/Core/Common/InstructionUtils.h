@@ -9,10 +9,12 @@
 #ifndef _MSC_VER
 #include <cpuid.h>
 void cpuid(int info[4], int InfoType);
+void cpuidex(int info[4], int InfoType, int SubLeaf);
 
 #else
 #include <intrin.h>
 #define cpuid(info, x)    __cpuidex(info, x, 0)
+#define cpuidex(info, x, y)    __cpuidex(info, x, y)
 #endif
 
 namespace SPTAG {
@@ -30,6 +32,9 @@ namespace SPTAG {
             static bool SSE2(void);
             static bool AVX2(void);
             static bool AVX512(void);
+            static bool AVX512VNNI(void);
+            static bool AVXVNNI(void);
+            static bool AVX512BF16(void);
             static void PrintInstructionSet(void);
 
         private:
@@ -44,6 +49,9 @@ namespace SPTAG {
                 bool HW_AVX;
                 bool HW_AVX2;
                 bool HW_AVX512;
+                bool HW_AVX512VNNI;
+                bool HW_AVXVNNI;
+                bool HW_AVX512BF16;
             };
         };
     }
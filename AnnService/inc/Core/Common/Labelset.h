@@ -29,6 +29,10 @@ namespace SPTAG
                 m_data.Initialize(size, 1, blockSize, capacity);
             }
 
+            inline void SetHugePages(Helper::HugePageMode mode) { m_data.SetHugePages(mode); }
+
+            inline bool PlaceOnNuma(int node) const { return m_data.PlaceOnNuma(node); }
+
             inline size_t Count() const { return m_inserted.load(); }
 
             inline bool Contains(const SizeType& key) const
@@ -614,6 +614,16 @@ break;
                 return ErrorCode::Success;
             }
 
+            // Take over the adjacency lists built by another index over the same rows.
+            void CopyFrom(const NeighborhoodGraph& other, SizeType rowsInBlock, SizeType capacity)
+            {
+                m_iGraphSize = other.m_iGraphSize;
+                m_iNeighborhoodSize = other.m_iNeighborhoodSize;
+                m_pNeighborhoodGraph.Initialize(m_iGraphSize, m_iNeighborhoodSize, rowsInBlock, capacity);
+                for (SizeType i = 0; i < m_iGraphSize; i++)
+                    std::memcpy(m_pNeighborhoodGraph[i], other.m_pNeighborhoodGraph[i], sizeof(SizeType) * m_iNeighborhoodSize);
+            }
+
             inline ErrorCode AddBatch(SizeType num)
             {
                 ErrorCode ret = m_pNeighborhoodGraph.AddBatch(num);
@@ -641,6 +651,20 @@ break;
 
             inline std::string Type() const { return m_pNeighborhoodGraph.Name(); }
 
+            inline void SetHugePages(Helper::HugePageMode mode) { m_pNeighborhoodGraph.SetHugePages(mode); }
+
+            inline bool PlaceOnNuma(int node) const { return m_pNeighborhoodGraph.PlaceOnNuma(node); }
+
+            // Copies the rows into p_other, which can then be searched but not updated.
+            void CopyTo(NeighborhoodGraph& p_other) const
+            {
+                std::vector<SizeType> indices(m_pNeighborhoodGraph.R());
+                for (SizeType i = 0; i < (SizeType)indices.size(); i++) indices[i] = i;
+                m_pNeighborhoodGraph.Refine(indices, p_other.m_pNeighborhoodGraph);
+                p_other.m_iGraphSize = m_pNeighborhoodGraph.R();
+                p_other.m_iNeighborhoodSize = m_iNeighborhoodSize;
+            }
+
             static std::shared_ptr<NeighborhoodGraph> CreateInstance(std::string type);
 
         protected:
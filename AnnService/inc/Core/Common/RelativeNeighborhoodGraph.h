@@ -18,14 +18,16 @@ namespace SPTAG
 
             void RebuildNeighbors(VectorIndex* index, const SizeType node, SizeType* nodes, const BasicResult* queryResults, const int numResults) {
                 DimensionType count = 0;
+                std::vector<float> dists(m_iNeighborhoodSize);
                 for (int j = 0; j < numResults && count < m_iNeighborhoodSize; j++) {
                     const BasicResult& item = queryResults[j];
                     if (item.VID < 0) break;
                     if (item.VID == node) continue;
 
+                    index->ComputeDistanceBatch(index->GetSample(item.VID), nodes, count, dists.data());
                     bool good = true;
                     for (DimensionType k = 0; k < count; k++) {
-                        if (m_fRNGFactor * index->ComputeDistance(index->GetSample(nodes[k]), index->GetSample(item.VID)) < item.Dist) {
+                        if (m_fRNGFactor * dists[k] < item.Dist) {
                             good = false;
                             break;
                         }
@@ -48,6 +48,15 @@ namespace SPTAG
             static void ComputeSum_AVX(float* pX, const float* pY, DimensionType length);
             static void ComputeSum_AVX512(float* pX, const float* pY, DimensionType length);
 
+            static void ComputeSum_SSE(Float16* pX, const Float16* pY, DimensionType length);
+            static void ComputeSum_AVX(Float16* pX, const Float16* pY, DimensionType length);
+            static void ComputeSum_AVX512(Float16* pX, const Float16* pY, DimensionType length);
+
+            // BFloat16 sums round every element through float, so they all use the naive loop.
+            static void ComputeSum_SSE(BFloat16* pX, const BFloat16* pY, DimensionType length) { ComputeSum_Naive(pX, pY, length); }
+            static void ComputeSum_AVX(BFloat16* pX, const BFloat16* pY, DimensionType length) { ComputeSum_Naive(pX, pY, length); }
+            static void ComputeSum_AVX512(BFloat16* pX, const BFloat16* pY, DimensionType length) { ComputeSum_Naive(pX, pY, length); }
+
              template<typename T>
             static inline void ComputeSum(T* p1, const T* p2, DimensionType length)
             {
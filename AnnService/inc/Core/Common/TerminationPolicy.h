@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_TERMINATIONPOLICY_H_
+#define _SPTAG_COMMON_TERMINATIONPOLICY_H_
+
+#include "WorkSpace.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Decides when a graph search may stop before the MaxCheck budget is spent. A policy is
+        // attached to a query through QueryResult::SetTerminationPolicy and shared between threads,
+        // so any per-query state must live in the WorkSpace, never in the policy itself.
+        class ITerminationPolicy
+        {
+        public:
+            virtual ~ITerminationPolicy() {}
+
+            // Called once the trees have seeded the graph queue. May lower p_space.m_iMaxCheck
+            // to give this query a smaller budget.
+            virtual void Start(WorkSpace& p_space) const {}
+
+            // Called after each graph node is expanded. p_worstDist is the current k-th result
+            // distance (MaxDist while fewer than k results are known) and p_improved tells whether
+            // the expansion changed it. Returning true ends the search with the current results.
+            virtual bool Stop(WorkSpace& p_space, float p_worstDist, bool p_improved) const = 0;
+        };
+
+        // Stops when the top-k has not changed for p_patience consecutive expansions.
+        class PatienceTermination : public ITerminationPolicy
+        {
+        public:
+            PatienceTermination(int p_patience) : m_patience(p_patience) {}
+
+            bool Stop(WorkSpace& p_space, float p_worstDist, bool p_improved) const override
+            {
+                if (p_improved || p_worstDist >= MaxDist)
+                {
+                    p_space.m_iNumOfContinuousNoImprovement = 0;
+                    return false;
+                }
+                return ++p_space.m_iNumOfContinuousNoImprovement >= m_patience;
+            }
+
+        private:
+            int m_patience;
+        };
+
+        // Scales the MaxCheck budget by how far the closest tree seed is from the query, relative to
+        // a reference seed distance measured on sample queries (e.g. their median). Queries whose
+        // seeds already land close to them get as little as p_minFraction of the budget; queries at
+        // or beyond the reference distance keep all of it.
+        class SeedDistanceBudget : public ITerminationPolicy
+        {
+        public:
+            SeedDistanceBudget(float p_referenceDist, float p_minFraction)
+                : m_referenceDist(p_referenceDist), m_minFraction(p_minFraction) {}
+
+            void Start(WorkSpace& p_space) const override
+            {
+                if (p_space.m_NGQueue.empty() || m_referenceDist <= 0) return;
+
+                float fraction = p_space.m_NGQueue.Top().distance / m_referenceDist;
+                fraction = min(max(fraction, m_minFraction), 1.0f);
+                p_space.m_iMaxCheck = max(1, (int)(p_space.m_iMaxCheck * fraction));
+            }
+
+            bool Stop(WorkSpace& p_space, float p_worstDist, bool p_improved) const override
+            {
+                return false;
+            }
+
+        private:
+            float m_referenceDist;
+            float m_minFraction;
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_TERMINATIONPOLICY_H_
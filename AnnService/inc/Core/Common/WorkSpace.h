@@ -9,6 +9,7 @@
 #include "Heap.h"
 
 #include <stdarg.h>
+#include <vector>
 
 namespace SPTAG
 {
@@ -20,18 +21,26 @@ namespace SPTAG
             // Max loop number in one hash block.
             static const int m_maxLoop = 8;
 
-            // Could we use the second hash block.
-            bool m_secondHash;
+            // A slot only holds an entry when its epoch equals the current one,
+            // so clear() starts a new epoch instead of wiping the blocks.
+            struct Slot
+            {
+                SizeType m_idx;
+                std::uint32_t m_epoch;
+            };
 
             int m_exp;
 
             // Max pool size.
             int m_poolSize;
 
+            // Current epoch, never 0 so that zeroed slots are always empty.
+            std::uint32_t m_epoch;
+
             // Record 2 hash tables.
             // [0~m_poolSize + 1) is the first block.
             // [m_poolSize + 1, 2*(m_poolSize + 1)) is the second block;
-            std::unique_ptr<SizeType[]> m_hashTable;
+            std::unique_ptr<Slot[]> m_hashTable;
 
 
             inline unsigned hash_func2(unsigned idx, int poolSize, int loop)
@@ -46,7 +55,7 @@ namespace SPTAG
             }
 
         public:
-            OptHashPosVector(): m_secondHash(false), m_exp(2), m_poolSize(8191) {}
+            OptHashPosVector(): m_exp(2), m_poolSize(8191), m_epoch(1) {}
 
             ~OptHashPosVector() {}
 
@@ -58,25 +67,20 @@ namespace SPTAG
                     ex++;
                     size >>= 1;
                 }
-                m_secondHash = true;
                 m_exp = exp;
                 m_poolSize = (1 << (ex + exp)) - 1;
-                m_hashTable.reset(new SizeType[(m_poolSize + 1) * 2]);
-                clear();
+                m_hashTable.reset(new Slot[(m_poolSize + 1) * 2]);
+                memset(m_hashTable.get(), 0, 2 * sizeof(Slot) * (m_poolSize + 1));
+                m_epoch = 1;
             }
 
             void clear()
             {
-                if (!m_secondHash)
-                {
-                    // Clear first block.
-                    memset(m_hashTable.get(), 0, sizeof(SizeType) * (m_poolSize + 1));
-                }
-                else
+                if (++m_epoch == 0)
                 {
-                    // Clear all blocks.
-                    m_secondHash = false;
-                    memset(m_hashTable.get(), 0, 2 * sizeof(SizeType) * (m_poolSize + 1));
+                    // Epoch wrapped around: stale slots could match again, so clear all blocks once.
+                    memset(m_hashTable.get(), 0, 2 * sizeof(Slot) * (m_poolSize + 1));
+                    m_epoch = 1;
                 }
             }
 
@@ -86,37 +90,37 @@ namespace SPTAG
 
             inline bool CheckAndSet(SizeType idx)
             {
-                // Inner Index is begin from 1
-                return _CheckAndSet(m_hashTable.get(), m_poolSize, true, idx + 1) == 0;
+                return _CheckAndSet(m_hashTable.get(), m_poolSize, true, idx) == 0;
             }
 
             inline void DoubleSize()
             {
-                int new_poolSize = ((m_poolSize + 1) << 1) - 1; 
-                SizeType* new_hashTable = new SizeType[(new_poolSize + 1) * 2];
-                memset(new_hashTable, 0, sizeof(SizeType) * (new_poolSize + 1) * 2);
+                int new_poolSize = ((m_poolSize + 1) << 1) - 1;
+                Slot* new_hashTable = new Slot[(new_poolSize + 1) * 2];
+                memset(new_hashTable, 0, sizeof(Slot) * (new_poolSize + 1) * 2);
 
-                m_secondHash = false;
                 for (int i = 0; i <= new_poolSize; i++)
-                    if (m_hashTable[i]) _CheckAndSet(new_hashTable, new_poolSize, true, m_hashTable[i]);
+                    if (m_hashTable[i].m_epoch == m_epoch) _CheckAndSet(new_hashTable, new_poolSize, true, m_hashTable[i].m_idx);
 
                 m_exp++;
                 m_poolSize = new_poolSize;
                 m_hashTable.reset(new_hashTable);
             }
 
-            inline int _CheckAndSet(SizeType* hashTable, int poolSize, bool isFirstTable, SizeType idx)
+            inline int _CheckAndSet(Slot* hashTable, int poolSize, bool isFirstTable, SizeType idx)
             {
                 unsigned index = hash_func((unsigned)idx, poolSize);
                 for (int loop = 0; loop < m_maxLoop; ++loop)
                 {
-                    if (!hashTable[index])
+                    Slot& slot = hashTable[index];
+                    if (slot.m_epoch != m_epoch)
                     {
                         // index first match and record it.
-                        hashTable[index] = idx;
+                        slot.m_idx = idx;
+                        slot.m_epoch = m_epoch;
                         return 1;
                     }
-                    if (hashTable[index] == idx)
+                    if (slot.m_idx == idx)
                     {
                         // Hit this item in hash table.
                         return 0;
@@ -128,7 +132,6 @@ namespace SPTAG
                 if (isFirstTable)
                 {
                     // Use second hash block.
-                    m_secondHash = true;
                     return _CheckAndSet(hashTable + poolSize + 1, poolSize, false, idx);
                 }
 
@@ -205,17 +208,18 @@ namespace SPTAG
 
             WorkSpace(WorkSpace& other) 
             {
-                Initialize(other.m_iMaxCheck, other.nodeCheckStatus.HashTableExponent());
+                Initialize(other.m_iMaxCheck, other.nodeCheckStatus.HashTableExponent(), other.m_NGQueue.Arity());
             }
 
-            void Initialize(int maxCheck, int hashExp)
+            void Initialize(int maxCheck, int hashExp, int heapArity = 2)
             {
                 nodeCheckStatus.Init(maxCheck, hashExp);
-                m_SPTQueue.Resize(maxCheck * 10);
-                m_NGQueue.Resize(maxCheck * 30);
+                m_SPTQueue.Resize(maxCheck * 10, heapArity);
+                m_NGQueue.Resize(maxCheck * 30, heapArity);
                 m_Results.Resize(maxCheck / 16);
 
                 m_iNumOfContinuousNoBetterPropagation = 0;
+                m_iNumOfContinuousNoImprovement = 0;
                 //m_iContinuousLimit = maxCheck / 64;
                 m_iNumberOfTreeCheckedLeaves = 0;
                 m_iNumberOfCheckedLeaves = 0;
@@ -226,17 +230,22 @@ namespace SPTAG
             {
                 int maxCheck = va_arg(arg, int);
                 int hashExp = va_arg(arg, int);
-                Initialize(maxCheck, hashExp);
+                int heapArity = va_arg(arg, int);
+                Initialize(maxCheck, hashExp, heapArity);
             }
 
             void Reset(int maxCheck, int resultNum)
             {
+                // Per-query MaxCheck overrides may ask for more than the pool was initialized with.
+                if (maxCheck > nodeCheckStatus.MaxCheck()) Initialize(maxCheck, nodeCheckStatus.HashTableExponent(), m_NGQueue.Arity());
+
                 nodeCheckStatus.clear();
                 m_SPTQueue.clear();
                 m_NGQueue.clear();
                 m_Results.clear(max(maxCheck / 16, resultNum));
 
                 m_iNumOfContinuousNoBetterPropagation = 0;
+                m_iNumOfContinuousNoImprovement = 0;
                 //m_iContinuousLimit = maxCheck / 64;
                 m_iNumberOfTreeCheckedLeaves = 0;
                 m_iNumberOfCheckedLeaves = 0;
@@ -253,12 +262,23 @@ namespace SPTAG
                 return nodeCheckStatus.HashTableExponent(); 
             }
 
+            inline void ReserveBatch(int size)
+            {
+                if ((int)m_batchIDs.size() < size)
+                {
+                    m_batchIDs.resize(size);
+                    m_batchDists.resize(size);
+                }
+            }
+
             static void Reset() {}
 
             OptHashPosVector nodeCheckStatus;
 
             // counter for dynamic pivoting
             int m_iNumOfContinuousNoBetterPropagation;
+            // counter for the query's termination policy
+            int m_iNumOfContinuousNoImprovement;
             int m_iContinuousLimit;
             int m_iNumberOfTreeCheckedLeaves;
             int m_iNumberOfCheckedLeaves;
@@ -274,6 +294,10 @@ namespace SPTAG
             Heap<NodeDistPair> m_nextBSPTQueue;
 
             DistPriorityQueue m_Results;
+
+            // Unvisited neighbors of the expanded node and their distances, scored in one batch call
+            std::vector<SizeType> m_batchIDs;
+            std::vector<float> m_batchDists;
         };
     }
 }
@@ -5,51 +5,54 @@
 #define _SPTAG_COMMON_WORKSPACEPOOL_H_
 
 #include "WorkSpace.h"
-#include "inc/Helper/ConcurrentSet.h"
+#include "inc/Helper/Numa.h"
 
-#include <list>
-#include <mutex>
+#include <atomic>
+#include <memory>
 #include <stdarg.h>
 
 namespace SPTAG
 {
     namespace COMMON
     {
-
+        // Workspaces are kept in one bounded freelist per NUMA node. Every thread has a home slot in
+        // those lists: it returns workspaces to the first free slot from there and rents from the first
+        // full one, so a thread usually gets back the workspace it used last, with its buffers still warm
+        // in its cache and on its node. Rent looks at the caller's node first and then at the others;
+        // only when all are empty is a new workspace allocated, by the renting thread so that its buffers
+        // are first touched on its node. None of these paths takes a lock.
         template<typename T>
         class WorkSpacePool
         {
         public:
-            WorkSpacePool() {}
+            WorkSpacePool() : m_nodes(Helper::Numa::NodeCount()), m_freeLists(new FreeList[m_nodes]) {}
 
-            ~WorkSpacePool() 
+            ~WorkSpacePool()
             {
-                std::shared_ptr<T> workspace;
-                while (m_workSpacePool.try_pop(workspace))
-                {
-                    workspace.reset();
-                }
+                for (int i = 0; i < m_nodes; i++) m_freeLists[i].Clear();
                 T::Reset();
             }
 
             std::shared_ptr<T> Rent()
             {
                 std::shared_ptr<T> workSpace;
+                int node = Helper::Numa::CurrentNode() % m_nodes;
+                for (int i = 0; i < m_nodes; i++)
                 {
-                    if (m_workSpacePool.try_pop(workSpace))
-                    {
-                    }
-                    else
-                    {
-                        workSpace.reset(new T(m_workSpace));
-                    }
+                    if (m_freeLists[(node + i) % m_nodes].TryPop(workSpace, HomeSlot())) return workSpace;
                 }
+                workSpace.reset(new T(m_workSpace));
                 return workSpace;
             }
 
             void Return(const std::shared_ptr<T>& p_workSpace)
             {
-                m_workSpacePool.push(p_workSpace);
+                int node = Helper::Numa::CurrentNode() % m_nodes;
+                for (int i = 0; i < m_nodes; i++)
+                {
+                    if (m_freeLists[(node + i) % m_nodes].TryPush(p_workSpace, HomeSlot())) return;
+                }
+                // Only reached when more workspaces are out than the freelists can hold; drop the surplus.
             }
 
             void Init(int size, ...)
@@ -58,15 +61,107 @@ namespace SPTAG
                 va_start(args, size);
                 m_workSpace.Initialize(args);
                 va_end(args);
+
+                // The slots are allocated once, so that a later Init never races with Rent and Return.
+                for (int i = 0; i < m_nodes; i++) m_freeLists[i].Reserve(max(2 * size, c_minFreeListSize));
+                FreeList& local = m_freeLists[Helper::Numa::CurrentNode() % m_nodes];
                 for (int i = 0; i < size; i++)
                 {
                     std::shared_ptr<T> workSpace(new T(m_workSpace));
-                    m_workSpacePool.push(std::move(workSpace));
+                    local.TryPush(workSpace, HomeSlot() + i);
                 }
             }
 
         private:
-            Helper::Concurrent::ConcurrentQueue<std::shared_ptr<T>> m_workSpacePool;
+            // Bounded freelist. A slot is claimed by a CAS on its state before its shared_ptr is touched,
+            // so pushes and pops never wait for each other: a slot that is busy is simply skipped.
+            class FreeList
+            {
+            public:
+                FreeList() : m_capacity(0), m_count(0) {}
+
+                void Reserve(int p_capacity)
+                {
+                    if (m_capacity > 0) return;
+                    m_slots.reset(new Slot[p_capacity]);
+                    m_capacity = p_capacity;
+                }
+
+                bool TryPush(const std::shared_ptr<T>& p_workSpace, std::uint32_t p_start)
+                {
+                    if (m_count.load(std::memory_order_relaxed) >= m_capacity) return false;
+
+                    for (int i = 0; i < m_capacity; i++)
+                    {
+                        Slot& slot = m_slots[(p_start + i) % m_capacity];
+                        int state = c_empty;
+                        if (slot.m_state.load(std::memory_order_relaxed) != c_empty ||
+                            !slot.m_state.compare_exchange_strong(state, c_busy, std::memory_order_acquire)) continue;
+
+                        slot.m_workSpace = p_workSpace;
+                        slot.m_state.store(c_full, std::memory_order_release);
+                        m_count.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool TryPop(std::shared_ptr<T>& p_workSpace, std::uint32_t p_start)
+                {
+                    if (m_count.load(std::memory_order_relaxed) <= 0) return false;
+
+                    for (int i = 0; i < m_capacity; i++)
+                    {
+                        Slot& slot = m_slots[(p_start + i) % m_capacity];
+                        int state = c_full;
+                        if (slot.m_state.load(std::memory_order_relaxed) != c_full ||
+                            !slot.m_state.compare_exchange_strong(state, c_busy, std::memory_order_acquire)) continue;
+
+                        p_workSpace = std::move(slot.m_workSpace);
+                        slot.m_workSpace.reset();
+                        slot.m_state.store(c_empty, std::memory_order_release);
+                        m_count.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                    return false;
+                }
+
+                void Clear()
+                {
+                    std::shared_ptr<T> workSpace;
+                    while (TryPop(workSpace, 0)) workSpace.reset();
+                }
+
+            private:
+                static const int c_empty = 0;
+                static const int c_busy = 1;
+                static const int c_full = 2;
+
+                struct Slot
+                {
+                    std::atomic<int> m_state;
+                    std::shared_ptr<T> m_workSpace;
+
+                    Slot() : m_state(c_empty) {}
+                };
+
+                std::unique_ptr<Slot[]> m_slots;
+                int m_capacity;
+                std::atomic<int> m_count;
+            };
+
+            static const int c_minFreeListSize = 64;
+
+            // Spread the threads' home slots over the freelist, in the order the threads first use a pool.
+            static std::uint32_t HomeSlot()
+            {
+                static std::atomic<std::uint32_t> next(0);
+                static thread_local std::uint32_t slot = next.fetch_add(1, std::memory_order_relaxed);
+                return slot;
+            }
+
+            int m_nodes;
+            std::unique_ptr<FreeList[]> m_freeLists;
             T m_workSpace;
         };
 
@@ -7,6 +7,8 @@ DefineVectorValueType(Int8, std::int8_t)
 DefineVectorValueType(UInt8, std::uint8_t)
 DefineVectorValueType(Int16, std::int16_t)
 DefineVectorValueType(Float, float)
+DefineVectorValueType(Float16, SPTAG::Float16)
+DefineVectorValueType(BFloat16, SPTAG::BFloat16)
 
 #endif // DefineVectorValueType
 
@@ -16,18 +18,38 @@ DefineVectorValueType2(Int8, Int8, std::int8_t, std::int8_t)
 DefineVectorValueType2(Int8, UInt8, std::int8_t, std::uint8_t)
 DefineVectorValueType2(Int8, Int16, std::int8_t, std::int16_t)
 DefineVectorValueType2(Int8, Float, std::int8_t, float)
+DefineVectorValueType2(Int8, Float16, std::int8_t, SPTAG::Float16)
+DefineVectorValueType2(Int8, BFloat16, std::int8_t, SPTAG::BFloat16)
 DefineVectorValueType2(UInt8, Int8, std::uint8_t, std::int8_t)
 DefineVectorValueType2(UInt8, UInt8, std::uint8_t, std::uint8_t)
 DefineVectorValueType2(UInt8, Int16, std::uint8_t, std::int16_t)
 DefineVectorValueType2(UInt8, Float, std::uint8_t, float)
+DefineVectorValueType2(UInt8, Float16, std::uint8_t, SPTAG::Float16)
+DefineVectorValueType2(UInt8, BFloat16, std::uint8_t, SPTAG::BFloat16)
 DefineVectorValueType2(Int16, Int8, std::int16_t, std::int8_t)
 DefineVectorValueType2(Int16, UInt8, std::int16_t, std::uint8_t)
 DefineVectorValueType2(Int16, Int16, std::int16_t, std::int16_t)
 DefineVectorValueType2(Int16, Float, std::int16_t, float)
+DefineVectorValueType2(Int16, Float16, std::int16_t, SPTAG::Float16)
+DefineVectorValueType2(Int16, BFloat16, std::int16_t, SPTAG::BFloat16)
 DefineVectorValueType2(Float, Int8, float, std::int8_t)
 DefineVectorValueType2(Float, UInt8, float, std::uint8_t)
 DefineVectorValueType2(Float, Int16, float, std::int16_t)
 DefineVectorValueType2(Float, Float, float, float)
+DefineVectorValueType2(Float, Float16, float, SPTAG::Float16)
+DefineVectorValueType2(Float, BFloat16, float, SPTAG::BFloat16)
+DefineVectorValueType2(Float16, Int8, SPTAG::Float16, std::int8_t)
+DefineVectorValueType2(Float16, UInt8, SPTAG::Float16, std::uint8_t)
+DefineVectorValueType2(Float16, Int16, SPTAG::Float16, std::int16_t)
+DefineVectorValueType2(Float16, Float, SPTAG::Float16, float)
+DefineVectorValueType2(Float16, Float16, SPTAG::Float16, SPTAG::Float16)
+DefineVectorValueType2(Float16, BFloat16, SPTAG::Float16, SPTAG::BFloat16)
+DefineVectorValueType2(BFloat16, Int8, SPTAG::BFloat16, std::int8_t)
+DefineVectorValueType2(BFloat16, UInt8, SPTAG::BFloat16, std::uint8_t)
+DefineVectorValueType2(BFloat16, Int16, SPTAG::BFloat16, std::int16_t)
+DefineVectorValueType2(BFloat16, Float, SPTAG::BFloat16, float)
+DefineVectorValueType2(BFloat16, Float16, SPTAG::BFloat16, SPTAG::Float16)
+DefineVectorValueType2(BFloat16, BFloat16, SPTAG::BFloat16, SPTAG::BFloat16)
 
 #endif // DefineVectorValueType2
 
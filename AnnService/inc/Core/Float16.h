@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_CORE_FLOAT16_H_
+#define _SPTAG_CORE_FLOAT16_H_
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace SPTAG
+{
+    // Storage-only half precision scalars. Arithmetic happens in float through the implicit
+    // conversions; the SIMD distance kernels convert whole registers instead.
+    struct Float16
+    {
+        std::uint16_t m_bits;
+
+        Float16() = default;
+        Float16(float p_value) : m_bits(FromFloat(p_value)) {}
+
+        operator float() const { return ToFloat(m_bits); }
+
+        Float16& operator+=(float p_value) { *this = Float16(float(*this) + p_value); return *this; }
+        Float16& operator-=(float p_value) { *this = Float16(float(*this) - p_value); return *this; }
+        Float16& operator*=(float p_value) { *this = Float16(float(*this) * p_value); return *this; }
+        Float16& operator/=(float p_value) { *this = Float16(float(*this) / p_value); return *this; }
+
+        static inline float ToFloat(std::uint16_t p_bits)
+        {
+            std::uint32_t sign = (std::uint32_t)(p_bits & 0x8000) << 16;
+            std::uint32_t exponent = (p_bits >> 10) & 0x1F;
+            std::uint32_t mantissa = p_bits & 0x3FF;
+            std::uint32_t bits;
+            if (exponent == 0x1F)
+            {
+                bits = sign | 0x7F800000 | (mantissa << 13);
+            }
+            else if (exponent != 0)
+            {
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            }
+            else if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // Subnormal half: renormalize into a float exponent.
+                exponent = 113;
+                while ((mantissa & 0x400) == 0)
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+            }
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        // Round to nearest even, matching vcvtps2ph with the default rounding mode.
+        static inline std::uint16_t FromFloat(float p_value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &p_value, sizeof(float));
+            std::uint16_t sign = (std::uint16_t)((bits >> 16) & 0x8000);
+            std::uint32_t abs = bits & 0x7FFFFFFF;
+
+            if (abs >= 0x7F800000) return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+            if (abs >= 0x477FF000) return sign | 0x7C00;
+
+            std::uint32_t exponent = abs >> 23;
+            if (exponent >= 113)
+            {
+                std::uint32_t half = ((exponent - 112) << 10) | ((abs & 0x7FFFFF) >> 13);
+                std::uint32_t rest = abs & 0x1FFF;
+                if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+                return sign | (std::uint16_t)half;
+            }
+            if (exponent < 102) return sign;
+
+            std::uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+            int shift = 126 - (int)exponent;
+            std::uint32_t half = mantissa >> shift;
+            std::uint32_t rest = mantissa & ((1u << shift) - 1);
+            std::uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1))) half++;
+            return sign | (std::uint16_t)half;
+        }
+    };
+
+    // The upper half of an IEEE float: same exponent range, 8 bit mantissa.
+    struct BFloat16
+    {
+        std::uint16_t m_bits;
+
+        BFloat16() = default;
+        BFloat16(float p_value) : m_bits(FromFloat(p_value)) {}
+
+        operator float() const { return ToFloat(m_bits); }
+
+        BFloat16& operator+=(float p_value) { *this = BFloat16(float(*this) + p_value); return *this; }
+        BFloat16& operator-=(float p_value) { *this = BFloat16(float(*this) - p_value); return *this; }
+        BFloat16& operator*=(float p_value) { *this = BFloat16(float(*this) * p_value); return *this; }
+        BFloat16& operator/=(float p_value) { *this = BFloat16(float(*this) / p_value); return *this; }
+
+        static inline float ToFloat(std::uint16_t p_bits)
+        {
+            std::uint32_t bits = (std::uint32_t)p_bits << 16;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        static inline std::uint16_t FromFloat(float p_value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &p_value, sizeof(float));
+            if ((bits & 0x7FFFFFFF) > 0x7F800000) return (std::uint16_t)((bits >> 16) | 0x40);
+            bits += 0x7FFF + ((bits >> 16) & 1);
+            return (std::uint16_t)(bits >> 16);
+        }
+    };
+
+    static_assert(sizeof(Float16) == 2 && sizeof(BFloat16) == 2, "Half precision types must be 2 bytes!");
+}
+
+namespace std
+{
+    template <>
+    class numeric_limits<SPTAG::Float16> : public numeric_limits<float>
+    {
+    public:
+        static SPTAG::Float16 min() { return SPTAG::Float16(6.103515625e-05f); }
+        static SPTAG::Float16 max() { return SPTAG::Float16(65504.0f); }
+        static SPTAG::Float16 lowest() { return SPTAG::Float16(-65504.0f); }
+    };
+
+    template <>
+    class numeric_limits<SPTAG::BFloat16> : public numeric_limits<float>
+    {
+    public:
+        static SPTAG::BFloat16 min() { return SPTAG::BFloat16((numeric_limits<float>::min)()); }
+        static SPTAG::BFloat16 max() { SPTAG::BFloat16 v; v.m_bits = 0x7F7F; return v; }
+        static SPTAG::BFloat16 lowest() { SPTAG::BFloat16 v; v.m_bits = 0xFF7F; return v; }
+    };
+}
+
+#endif // _SPTAG_CORE_FLOAT16_H_
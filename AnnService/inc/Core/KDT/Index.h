@@ -13,6 +13,7 @@
 #include "inc/Core/Common/Dataset.h"
 #include "inc/Core/Common/WorkSpace.h"
 #include "inc/Core/Common/WorkSpacePool.h"
+#include "inc/Core/Common/TerminationPolicy.h"
 #include "inc/Core/Common/RelativeNeighborhoodGraph.h"
 #include "inc/Core/Common/KDTree.h"
 #include "inc/Core/Common/Labelset.h"
@@ -76,6 +77,7 @@ namespace SPTAG
 
             DistCalcMethod m_iDistCalcMethod;
             std::function<float(const T*, const T*, DimensionType)> m_fComputeDistance;
+            COMMON::DistanceBatchCalcReturn<T> m_fComputeDistanceBatch;
             int m_iBaseSquare;
  
             int m_iMaxCheck;
@@ -83,6 +85,8 @@ namespace SPTAG
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
             int m_iHashTableExp;
+            int m_iHeapArity;
+            int m_iHugePages;
 
         public:
             Index()
@@ -95,6 +99,7 @@ namespace SPTAG
 
                 m_pSamples.SetName("Vector");
                 m_fComputeDistance = std::function<float(const T*, const T*, DimensionType)>(COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod));
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod);
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             }
 
@@ -112,7 +117,7 @@ namespace SPTAG
             void SetQuantizer(std::shared_ptr<SPTAG::COMMON::IQuantizer> quantizer);
             
             inline float AccurateDistance(const void* pX, const void* pY) const {
-                if (m_iDistCalcMethod == DistCalcMethod::L2) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                if (m_iDistCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
 
                 float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
                 float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
@@ -120,6 +125,22 @@ namespace SPTAG
                 return 1.0f - xy / (sqrt(xx) * sqrt(yy));
             }
             inline float ComputeDistance(const void* pX, const void* pY) const { return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C()); }
+            inline void ComputeDistanceBatch(const void* pX, const SizeType* pIDs, int count, float* pDist) const
+            {
+                if (m_fComputeDistanceBatch == nullptr)
+                {
+                    for (int i = 0; i < count; i++) pDist[i] = m_fComputeDistance((const T*)pX, m_pSamples[pIDs[i]], m_pSamples.C());
+                    return;
+                }
+
+                const T* rows[64];
+                for (int begin = 0; begin < count; begin += 64)
+                {
+                    int num = min(count - begin, 64);
+                    for (int i = 0; i < num; i++) rows[i] = m_pSamples[pIDs[begin + i]];
+                    m_fComputeDistanceBatch((const T*)pX, rows, num, m_pSamples.C(), pDist + begin);
+                }
+            }
             inline const void* GetSample(const SizeType idx) const { return (void*)m_pSamples[idx]; }
             inline bool ContainSample(const SizeType idx) const { return idx >= 0 && idx < m_deletedID.R() && !m_deletedID.Contains(idx); }
             inline bool NeedRefine() const { return m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
@@ -152,6 +173,7 @@ namespace SPTAG
 
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, bool p_normalized = false, bool p_shareOwnership = false);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta = false, bool p_searchDeleted = false) const;
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
             ErrorCode SearchTree(QueryResult &p_query) const;
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false, bool p_normalized = false);
@@ -166,8 +188,36 @@ namespace SPTAG
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
 
         private:
+            inline void SelectDistanceFunction()
+            {
+                if (m_pQuantizer)
+                {
+                    m_fComputeDistance = m_pQuantizer->DistanceCalcSelector<T>(m_iDistCalcMethod);
+                    m_fComputeDistanceBatch = nullptr;
+                }
+                else
+                {
+                    m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod, m_pSamples.C());
+                    m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod, m_pSamples.C());
+                }
+            }
+
+            // Back the sample, graph and deleted ID storage allocated from now on with huge pages.
+            inline void SelectHugePages()
+            {
+                Helper::HugePageMode mode = (Helper::HugePageMode)m_iHugePages;
+                m_pSamples.SetHugePages(mode);
+                m_pGraph.SetHugePages(mode);
+                m_deletedID.SetHugePages(mode);
+            }
+
             template <typename Q>
             void SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const;
+            // Scores every vector accepted by the filter; used when it accepts fewer vectors than MaxCheck.
+            void SearchIndexByFilter(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, const IFilter& p_filter, bool p_searchDeleted) const;
+            // Graph search bounded by the radius rather than by the k-th result; appends to p_results unsorted.
+            template <typename Q>
+            void SearchIndexRange(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_searchDeleted) const;
         };
     } // namespace KDT
 } // namespace SPTAG
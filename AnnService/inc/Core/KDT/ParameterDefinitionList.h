@@ -45,6 +45,8 @@ DefineKDTParameter(m_iThresholdOfNumberOfContinuousNoBetterPropagation, int, 3L,
 DefineKDTParameter(m_iNumberOfInitialDynamicPivots, int, 50L, "NumberOfInitialDynamicPivots")
 DefineKDTParameter(m_iNumberOfOtherDynamicPivots, int, 4L, "NumberOfOtherDynamicPivots")
 DefineKDTParameter(m_iHashTableExp, int, 2L, "HashTableExponent")
+DefineKDTParameter(m_iHugePages, int, 0L, "HugePages") // 0: regular pages, 1: 2 MB pages, 2: 1 GB pages; falls back when unavailable
+DefineKDTParameter(m_iHeapArity, int, 2L, "HeapArity") // Fan-out of the graph and tree search queues: 2, 4 or 8
 DefineKDTParameter(m_iDataBlockSize, int, 1024 * 1024, "DataBlockSize")
 DefineKDTParameter(m_iDataCapacity, int, MaxSize, "DataCapacity")
 DefineKDTParameter(m_iMetaRecordSize, int, 10, "MetaRecordSize")
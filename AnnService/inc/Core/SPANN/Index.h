@@ -25,6 +25,7 @@
 #include "IExtraSearcher.h"
 #include "Options.h"
 
+#include <algorithm>
 #include <functional>
 #include <shared_mutex>
 
@@ -79,7 +80,7 @@ namespace SPTAG
             void SetQuantizer(std::shared_ptr<SPTAG::COMMON::IQuantizer> quantizer);
             
             inline float AccurateDistance(const void* pX, const void* pY) const { 
-                if (m_options.m_distCalcMethod == DistCalcMethod::L2) return m_fComputeDistance((const T*)pX, (const T*)pY, m_options.m_dim);
+                if (m_options.m_distCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_options.m_dim);
 
                 float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_options.m_dim);
                 float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_options.m_dim);
@@ -119,6 +120,7 @@ namespace SPTAG
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, bool p_normalized = false, bool p_shareOwnership = false);
             ErrorCode BuildIndex(bool p_normalized = false);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta = false, bool p_searchDeleted = false) const;
             ErrorCode SearchDiskIndex(QueryResult& p_query, SearchStats* p_stats = nullptr) const;
             ErrorCode DebugSearchDiskIndex(QueryResult& p_query, int p_subInternalResultNum, int p_internalResultNum,
                 SearchStats* p_stats = nullptr, std::set<int>* truth = nullptr, std::map<int, std::set<int>>* found = nullptr) const;
@@ -139,6 +141,29 @@ namespace SPTAG
             ErrorCode RefineIndex(const std::vector<std::shared_ptr<Helper::DiskIO>>& p_indexStreams, IAbortOperation* p_abort) { return ErrorCode::Undefined; }
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex) { return ErrorCode::Undefined; }
         private:
+            // The buffers of the workspaces are sized for SearchInternalResultNum, so a query can only lower it.
+            inline int GetInternalResultNum(const QueryResult& p_query) const
+            {
+                return min(SearchOptions::Pick(p_query.GetSearchOptions().m_searchInternalResultNum, m_options.m_searchInternalResultNum), m_options.m_searchInternalResultNum);
+            }
+
+            // Drops the heads the filter rejects, after their postings have been picked. The holes are sorted
+            // to the end so that the reversed list is still a valid result heap for the posting search.
+            static inline void FilterHeads(QueryResult& p_results, const IFilter& p_filter)
+            {
+                for (int i = 0; i < p_results.GetResultNum(); i++)
+                {
+                    BasicResult* res = p_results.GetResult(i);
+                    if (res->VID >= 0 && !p_filter.Accept(res->VID))
+                    {
+                        res->VID = -1;
+                        res->Dist = MaxDist;
+                    }
+                }
+                std::sort(p_results.GetResults(), p_results.GetResults() + p_results.GetResultNum(),
+                    [](const BasicResult& a, const BasicResult& b) { return a.Dist < b.Dist; });
+            }
+
             bool CheckHeadIndexType();
             void SelectHeadAdjustOptions(int p_vectorCount);
             int SelectHeadDynamicallyInternal(const std::shared_ptr<COMMON::BKTree> p_tree, int p_nodeID, const Options& p_opts, std::vector<int>& p_selected);
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_SEARCHFILTER_H_
+#define _SPTAG_SEARCHFILTER_H_
+
+#include "CommonDataStructure.h"
+
+#include <functional>
+#include <vector>
+
+namespace SPTAG
+{
+
+// Predicate over vector ids, evaluated while the index is searched. Only accepted vectors are returned;
+// rejected ones are still traversed, so the graph stays connected. Filters are shared between threads.
+class IFilter
+{
+public:
+    virtual ~IFilter() {}
+
+    virtual bool Accept(SizeType p_vid) const = 0;
+
+    // Number of accepted ids, or -1 when unknown. When it is no larger than the query's MaxCheck,
+    // BKT and KDT score the accepted vectors directly instead of walking the graph.
+    virtual SizeType AcceptedCount() const { return -1; }
+
+    // Graph nodes a search over p_total vectors may check. Rejected vectors never fill the results,
+    // so MaxCheck is scaled by the selectivity; without an accepted count the whole graph may be walked.
+    SizeType CheckBudget(int p_maxCheck, SizeType p_total) const
+    {
+        SizeType accepted = AcceptedCount();
+        if (accepted <= 0) return p_total;
+        return (SizeType)min((std::int64_t)p_maxCheck * p_total / accepted, (std::int64_t)p_total);
+    }
+
+    // First accepted id in [p_from, p_end), or p_end when there is none.
+    virtual SizeType NextAccepted(SizeType p_from, SizeType p_end) const
+    {
+        while (p_from < p_end && !Accept(p_from)) p_from++;
+        return p_from;
+    }
+};
+
+
+// Accepts the ids whose bit is set, e.g. one bitmap per tenant or language built from an attribute column.
+class BitmapFilter : public IFilter
+{
+public:
+    BitmapFilter(SizeType p_size) : m_size(p_size), m_count(0), m_bits((p_size + 63) / 64, 0) {}
+
+    void Set(SizeType p_vid)
+    {
+        if (p_vid < 0 || p_vid >= m_size) return;
+
+        std::uint64_t mask = ((std::uint64_t)1) << (p_vid & 63);
+        if ((m_bits[p_vid >> 6] & mask) == 0)
+        {
+            m_bits[p_vid >> 6] |= mask;
+            m_count++;
+        }
+    }
+
+    bool Accept(SizeType p_vid) const override
+    {
+        return p_vid >= 0 && p_vid < m_size && ((m_bits[p_vid >> 6] >> (p_vid & 63)) & 1);
+    }
+
+    SizeType AcceptedCount() const override { return m_count; }
+
+    SizeType NextAccepted(SizeType p_from, SizeType p_end) const override
+    {
+        if (p_end > m_size) p_end = m_size;
+        while (p_from < p_end)
+        {
+            std::uint64_t word = m_bits[p_from >> 6] >> (p_from & 63);
+            if (word != 0)
+            {
+                SizeType vid = p_from + CountTrailingZeros(word);
+                return (vid < p_end) ? vid : p_end;
+            }
+            p_from = (p_from | 63) + 1;
+        }
+        return p_end;
+    }
+
+private:
+    static inline int CountTrailingZeros(std::uint64_t p_word)
+    {
+        int n = 0;
+        while ((p_word & 1) == 0)
+        {
+            p_word >>= 1;
+            n++;
+        }
+        return n;
+    }
+
+    SizeType m_size;
+    SizeType m_count;
+    std::vector<std::uint64_t> m_bits;
+};
+
+
+// Accepts the ids for which the callback returns true.
+class CallbackFilter : public IFilter
+{
+public:
+    CallbackFilter(std::function<bool(SizeType)> p_accept, SizeType p_acceptedCount = -1)
+        : m_accept(std::move(p_accept)), m_acceptedCount(p_acceptedCount) {}
+
+    bool Accept(SizeType p_vid) const override { return m_accept(p_vid); }
+
+    SizeType AcceptedCount() const override { return m_acceptedCount; }
+
+private:
+    std::function<bool(SizeType)> m_accept;
+    SizeType m_acceptedCount;
+};
+
+} // namespace SPTAG
+
+#endif // _SPTAG_SEARCHFILTER_H_
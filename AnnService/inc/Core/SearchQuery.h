@@ -7,9 +7,53 @@
 #include "SearchResult.h"
 
 #include <cstring>
+#include <memory>
 
 namespace SPTAG
 {
+class IFilter;
+
+namespace COMMON
+{
+class ITerminationPolicy;
+}
+
+// Per-query overrides of the index search parameters. A negative value keeps the index setting,
+// so one index can serve queries with different latency and recall targets without SetParameter.
+struct SearchOptions
+{
+    // Graph nodes to check (BKT, KDT and the SPANN head index).
+    int m_maxCheck;
+
+    // KDT: expansions without a closer neighbor before the trees are searched again.
+    int m_continuousLimit;
+
+    // Tree leaves used to seed the graph search, and added each time the trees are searched again (BKT, KDT).
+    int m_initialDynamicPivots;
+    int m_otherDynamicPivots;
+
+    // Also return vectors that have been deleted.
+    bool m_searchDeleted;
+
+    // SPANN: postings to read; can only lower the index's SearchInternalResultNum, which sizes its buffers.
+    int m_searchInternalResultNum;
+
+    SearchOptions()
+        : m_maxCheck(-1),
+          m_continuousLimit(-1),
+          m_initialDynamicPivots(-1),
+          m_otherDynamicPivots(-1),
+          m_searchDeleted(false),
+          m_searchInternalResultNum(-1)
+    {
+    }
+
+    // p_value when it is set, p_default otherwise.
+    static inline int Pick(int p_value, int p_default)
+    {
+        return p_value >= 0 ? p_value : p_default;
+    }
+};
 
 // Space to save temporary answer, similar with TopKCache
 class QueryResult
@@ -58,6 +102,9 @@ public:
             m_quantizedTarget = ALIGN_ALLOC(m_quantizedSize);
             std::copy(reinterpret_cast<std::uint8_t*>(p_other.m_quantizedTarget), reinterpret_cast<std::uint8_t*>(p_other.m_quantizedTarget) + m_quantizedSize, reinterpret_cast<std::uint8_t*>(m_quantizedTarget));
         }
+        m_terminationPolicy = p_other.m_terminationPolicy;
+        m_searchOptions = p_other.m_searchOptions;
+        m_filter = p_other.m_filter;
     }
 
 
@@ -76,6 +123,9 @@ public:
             m_quantizedTarget = ALIGN_ALLOC(m_quantizedSize);
             std::copy(reinterpret_cast<std::uint8_t*>(p_other.m_quantizedTarget), reinterpret_cast<std::uint8_t*>(p_other.m_quantizedTarget) + m_quantizedSize, reinterpret_cast<std::uint8_t*>(m_quantizedTarget));
         }
+        m_terminationPolicy = p_other.m_terminationPolicy;
+        m_searchOptions = p_other.m_searchOptions;
+        m_filter = p_other.m_filter;
         return *this;
     }
 
@@ -146,6 +196,44 @@ public:
     }
 
 
+    // Optional early-termination policy for this query; nullptr searches until MaxCheck is spent.
+    inline void SetTerminationPolicy(std::shared_ptr<const COMMON::ITerminationPolicy> p_policy)
+    {
+        m_terminationPolicy = std::move(p_policy);
+    }
+
+
+    inline const std::shared_ptr<const COMMON::ITerminationPolicy>& GetTerminationPolicy() const
+    {
+        return m_terminationPolicy;
+    }
+
+
+    // Optional predicate; only vectors it accepts are returned.
+    inline void SetFilter(std::shared_ptr<const IFilter> p_filter)
+    {
+        m_filter = std::move(p_filter);
+    }
+
+
+    inline const std::shared_ptr<const IFilter>& GetFilter() const
+    {
+        return m_filter;
+    }
+
+
+    inline void SetSearchOptions(const SearchOptions& p_options)
+    {
+        m_searchOptions = p_options;
+    }
+
+
+    inline const SearchOptions& GetSearchOptions() const
+    {
+        return m_searchOptions;
+    }
+
+
     inline BasicResult* GetResult(int i) const
     {
         return i < m_resultNum ? m_results.Data() + i : nullptr;
@@ -241,6 +329,12 @@ protected:
     bool m_withMeta;
 
     Array<BasicResult> m_results;
+
+    std::shared_ptr<const COMMON::ITerminationPolicy> m_terminationPolicy;
+
+    SearchOptions m_searchOptions;
+
+    std::shared_ptr<const IFilter> m_filter;
 };
 } // namespace SPTAG
 
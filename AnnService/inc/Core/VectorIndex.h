@@ -6,9 +6,11 @@
 
 #include "Common.h"
 #include "SearchQuery.h"
+#include "SearchFilter.h"
 #include "VectorSet.h"
 #include "MetadataSet.h"
 #include "inc/Helper/SimpleIniReader.h"
+#include "inc/Helper/MemoryMappedFile.h"
 #include <unordered_set>
 #include "inc/Core/Common/IQuantizer.h"
 
@@ -44,6 +46,7 @@ public:
 
     virtual float AccurateDistance(const void* pX, const void* pY) const = 0;
     virtual float ComputeDistance(const void* pX, const void* pY) const = 0;
+    virtual void ComputeDistanceBatch(const void* pX, const SizeType* pIDs, int count, float* pDist) const;
     virtual const void* GetSample(const SizeType idx) const = 0;
     virtual bool ContainSample(const SizeType idx) const = 0;
     virtual bool NeedRefine() const = 0;
@@ -85,6 +88,10 @@ public:
 
     virtual ErrorCode SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const;
 
+    // Finds the vectors within p_radius of p_vector, in the units of the index distance (squared L2 for L2),
+    // and returns them closest first in p_results, which grows to fit but stops at p_maxResults entries.
+    virtual ErrorCode SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta = false, bool p_searchDeleted = false) const;
+
     virtual void ApproximateRNG(std::shared_ptr<VectorSet>& fullVectors, std::unordered_set<SizeType>& exceptIDS, int candidateNum, Edge* selections, int replicaCount, int numThreads, int numTrees, int leafSize, float RNGFactor, int numGPUs);
 
     static void SortSelections(std::vector<Edge>* selections);
@@ -115,7 +122,9 @@ public:
 
     static std::shared_ptr<VectorIndex> CreateInstance(IndexAlgoType p_algo, VectorValueType p_valuetype);
 
-    static ErrorCode LoadIndex(const std::string& p_loaderFilePath, std::shared_ptr<VectorIndex>& p_vectorIndex);
+    // p_memoryMapped maps the vector, graph and deleted ID files of BKT/KDT indexes instead of reading them;
+    // p_populate prefaults those mappings.
+    static ErrorCode LoadIndex(const std::string& p_loaderFilePath, std::shared_ptr<VectorIndex>& p_vectorIndex, bool p_memoryMapped = false, bool p_populate = false);
 
     static ErrorCode LoadIndexFromFile(const std::string& p_file, std::shared_ptr<VectorIndex>& p_vectorIndex);
 
@@ -164,6 +173,7 @@ protected:
     std::string m_sQuantizerFile = "quantizer.bin";
     std::shared_ptr<MetadataSet> m_pMetadata;
     std::shared_ptr<void> m_pMetaToVec;
+    std::vector<std::shared_ptr<Helper::MemoryMappedFile>> m_pMappedFiles;
 
 public:
     int m_iDataBlockSize = 1024 * 1024;
@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_HELPER_HUGEPAGEALLOCATOR_H_
+#define _SPTAG_HELPER_HUGEPAGEALLOCATOR_H_
+
+#include <cstddef>
+
+namespace SPTAG
+{
+    namespace Helper
+    {
+        enum class HugePageMode
+        {
+            None = 0,
+            Page2M = 1,
+            Page1G = 2
+        };
+
+        // Anonymous memory backed by huge pages: explicit hugetlb pages of the requested size first
+        // (falling back from 1 GB to 2 MB), then transparent huge pages via madvise. Returns nullptr
+        // when the request is smaller than a huge page or the platform has no huge page support, so
+        // callers can fall back to their normal allocator. p_allocated receives the mapped length.
+        void* HugePageAlloc(std::size_t p_size, HugePageMode p_mode, std::size_t& p_allocated);
+
+        void HugePageFree(void* p_ptr, std::size_t p_allocated);
+    }
+}
+
+#endif // _SPTAG_HELPER_HUGEPAGEALLOCATOR_H_
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_HELPER_MEMORYMAPPEDFILE_H_
+#define _SPTAG_HELPER_MEMORYMAPPEDFILE_H_
+
+#include <cstdint>
+
+namespace SPTAG
+{
+    namespace Helper
+    {
+        // Private copy-on-write mapping of a whole file. Pages stay shared through the page cache
+        // until the process writes to them (deletes, graph updates), so several searchers on one
+        // host can map the same index files.
+        class MemoryMappedFile
+        {
+        public:
+            MemoryMappedFile();
+
+            ~MemoryMappedFile();
+
+            // p_populate prefaults the whole file up front; otherwise pages are faulted in by the
+            // first searches and the kernel is told not to read ahead around them.
+            bool Initialize(const char* p_filePath, bool p_populate = false);
+
+            void ShutDown();
+
+            inline char* Data() const { return m_data; }
+
+            inline std::uint64_t Size() const { return m_size; }
+
+        private:
+            char* m_data;
+            std::uint64_t m_size;
+#ifdef _MSC_VER
+            void* m_fileHandle;
+            void* m_mappingHandle;
+#endif
+        };
+    }
+}
+
+#endif // _SPTAG_HELPER_MEMORYMAPPEDFILE_H_
@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_HELPER_NUMA_H_
+#define _SPTAG_HELPER_NUMA_H_
+
+#include <cstddef>
+
+namespace SPTAG
+{
+namespace Helper
+{
+namespace Numa
+{
+
+// Number of online NUMA nodes; 1 when the topology cannot be read or the platform has no NUMA support.
+int NodeCount();
+
+// Node of the CPU the calling thread is running on, in [0, NodeCount()).
+int CurrentNode();
+
+// Spread the pages of [p_ptr, p_ptr + p_size) round-robin over all nodes. Pages already touched
+// are migrated. Only whole pages inside the range are affected.
+bool Interleave(void* p_ptr, std::size_t p_size);
+
+// Place the pages of [p_ptr, p_ptr + p_size) on p_node, migrating pages already touched.
+bool Bind(void* p_ptr, std::size_t p_size, int p_node);
+
+// Restrict the calling thread to the CPUs of p_node.
+bool PinThread(int p_node);
+
+} // namespace Numa
+} // namespace Helper
+} // namespace SPTAG
+
+#endif // _SPTAG_HELPER_NUMA_H_
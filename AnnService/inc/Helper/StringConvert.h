@@ -133,6 +133,34 @@ inline bool ConvertStringTo<float>(const char* p_str, float& p_value)
 }
 
 
+template <>
+inline bool ConvertStringTo<Float16>(const char* p_str, Float16& p_value)
+{
+    float value;
+    if (!ConvertStringTo<float>(p_str, value))
+    {
+        return false;
+    }
+
+    p_value = Float16(value);
+    return true;
+}
+
+
+template <>
+inline bool ConvertStringTo<BFloat16>(const char* p_str, BFloat16& p_value)
+{
+    float value;
+    if (!ConvertStringTo<float>(p_str, value))
+    {
+        return false;
+    }
+
+    p_value = BFloat16(value);
+    return true;
+}
+
+
 template <>
 inline bool ConvertStringTo<double>(const char* p_str, double& p_value)
 {
@@ -35,6 +35,8 @@ public:
 private:
     void RunSocketMode();
 
+    void PinThreadsToNuma(SizeType p_threadNum);
+
     void RunInteractiveMode();
 
     void SearchHanlder(Socket::ConnectionID p_localConnectionID, Socket::Packet p_packet);
@@ -28,6 +28,9 @@ struct ServiceSettings
     SizeType m_threadNum;
 
     SizeType m_socketThreadNum;
+
+    // Spread the search threads over the NUMA nodes, one node per thread, round robin.
+    bool m_numaPinThreads;
 };
 
 
@@ -3,6 +3,7 @@
 
 #include "inc/Core/BKT/Index.h"
 #include <chrono>
+#include <thread>
 
 #pragma warning(disable:4242)  // '=' : conversion from 'int' to 'short', possible loss of data
 #pragma warning(disable:4244)  // '=' : conversion from 'int' to 'short', possible loss of data
@@ -34,11 +35,13 @@ namespace SPTAG
             if (m_pQuantizer)
             {
                 m_fComputeDistance = m_pQuantizer->DistanceCalcSelector<std::uint8_t>(m_iDistCalcMethod);
+                m_fComputeDistanceBatch = nullptr;
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? m_pQuantizer->GetBase() * m_pQuantizer->GetBase() : 1;
             }
             else
             {
                 m_fComputeDistance = COMMON::DistanceCalcSelector<std::uint8_t>(m_iDistCalcMethod);
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<std::uint8_t>(m_iDistCalcMethod);
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<std::uint8_t>() * COMMON::Utils::GetBase<std::uint8_t>() : 1;
             }
 
@@ -60,16 +63,20 @@ namespace SPTAG
         {
             if (p_indexBlobs.size() < 3) return ErrorCode::LackOfInputs;
 
+            SelectHugePages();
+
             if (m_pSamples.Load((char*)p_indexBlobs[0].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (m_pTrees.LoadTrees((char*)p_indexBlobs[1].Data()) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (m_pGraph.LoadGraph((char*)p_indexBlobs[2].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (p_indexBlobs.size() <= 3) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if (m_deletedID.Load((char*)p_indexBlobs[3].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
 
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
+            PlaceOnNuma();
             return ErrorCode::Success;
         }
 
@@ -78,6 +85,7 @@ namespace SPTAG
         {
             if (p_indexStreams.size() < 4) return ErrorCode::LackOfInputs;
 
+            SelectHugePages();
             ErrorCode ret = ErrorCode::Success;
             if (p_indexStreams[0] == nullptr || (ret = m_pSamples.Load(p_indexStreams[0], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
             if (p_indexStreams[1] == nullptr || (ret = m_pTrees.LoadTrees(p_indexStreams[1])) != ErrorCode::Success) return ret;
@@ -85,10 +93,12 @@ namespace SPTAG
             if (p_indexStreams[3] == nullptr) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if ((ret = m_deletedID.Load(p_indexStreams[3], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
 
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
+            PlaceOnNuma();
             return ret;
         }
 
@@ -184,21 +194,24 @@ namespace SPTAG
 
 #define Search(CheckDeleted, CheckDuplicated) \
         std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
-        m_pTrees.InitSearchTrees(m_pSamples, m_fComputeDistance, p_query, p_space); \
-        m_pTrees.SearchTrees(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfInitialDynamicPivots); \
-        const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1; \
+        trees.InitSearchTrees(samples, m_fComputeDistance, p_query, p_space); \
+        trees.SearchTrees(samples, m_fComputeDistance, p_query, p_space, initialPivots); \
+        if (policy != nullptr) policy->Start(p_space); \
+        const DimensionType checkPos = graph.m_iNeighborhoodSize - 1; \
+        p_space.ReserveBatch(checkPos + 1); \
         while (!p_space.m_NGQueue.empty()) { \
             NodeDistPair gnode = p_space.m_NGQueue.pop(); \
             SizeType tmpNode = gnode.node; \
-            const SizeType *node = m_pGraph[tmpNode]; \
+            float worstBefore = p_query.worstDist(); \
+            const SizeType *node = graph[tmpNode]; \
             _mm_prefetch((const char *)node, _MM_HINT_T0); \
             for (DimensionType i = 0; i <= checkPos; i++) { \
-                _mm_prefetch((const char *)(m_pSamples)[node[i]], _MM_HINT_T0); \
+                _mm_prefetch((const char *)samples[node[i]], _MM_HINT_T0); \
             } \
             if (gnode.distance <= p_query.worstDist()) { \
                 SizeType checkNode = node[checkPos]; \
                 if (checkNode < -1) { \
-                    const COMMON::BKTNode& tnode = m_pTrees[-2 - checkNode]; \
+                    const COMMON::BKTNode& tnode = trees[-2 - checkNode]; \
                     SizeType i = -tnode.childStart; \
                     do { \
                         CheckDeleted \
@@ -206,7 +219,7 @@ namespace SPTAG
                             CheckDuplicated \
                             break; \
                         } \
-                        tmpNode = m_pTrees[i].centerid; \
+                        tmpNode = trees[i].centerid; \
                     } while (i++ < tnode.childEnd); \
                } else { \
                    CheckDeleted \
@@ -222,19 +235,26 @@ namespace SPTAG
                     } \
                 } \
             } \
+            int batchCount = 0; \
             for (DimensionType i = 0; i <= checkPos; i++) { \
                 SizeType nn_index = node[i]; \
                 if (nn_index < 0) break; \
                 if (p_space.CheckAndSet(nn_index)) continue; \
-                float distance2leaf = m_fComputeDistance(p_query.GetQuantizedTarget(), (m_pSamples)[nn_index], GetFeatureDim()); \
+                p_space.m_batchIDs[batchCount++] = nn_index; \
+            } \
+            ComputeDistanceBatch(samples, p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data()); \
+            for (int i = 0; i < batchCount; i++) { \
+                float distance2leaf = p_space.m_batchDists[i]; \
                 p_space.m_iNumberOfCheckedLeaves++; \
                 if (p_space.m_Results.insert(distance2leaf)) { \
-                    p_space.m_NGQueue.insert(NodeDistPair(nn_index, distance2leaf)); \
+                    p_space.m_NGQueue.insert(NodeDistPair(p_space.m_batchIDs[i], distance2leaf)); \
                 } \
             } \
             if (p_space.m_NGQueue.Top().distance > p_space.m_SPTQueue.Top().distance) { \
-                m_pTrees.SearchTrees(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
+                trees.SearchTrees(samples, m_fComputeDistance, p_query, p_space, otherPivots + p_space.m_iNumberOfCheckedLeaves); \
             } \
+            if (policy != nullptr && policy->Stop(p_space, p_query.worstDist(), p_query.worstDist() < worstBefore)) break; \
+            if (p_space.m_iNumberOfCheckedLeaves > checkBudget) break; \
         } \
         p_query.SortResult(); \
 
@@ -247,7 +267,35 @@ namespace SPTAG
                 p_query.SetTarget(p_query.GetTarget(), m_pQuantizer);
             }
 
-            if (m_deletedID.Count() == 0 || p_searchDeleted)
+            std::shared_ptr<NumaReplicaSet> replicas = std::atomic_load(&m_pNumaReplicas);
+            const NumaReplica* replica = LocalReplica(replicas);
+            const COMMON::Dataset<T>& samples = (replica == nullptr) ? m_pSamples : replica->m_pSamples;
+            const COMMON::BKTree& trees = (replica == nullptr) ? m_pTrees : replica->m_pTrees;
+            const COMMON::RelativeNeighborhoodGraph& graph = (replica == nullptr) ? m_pGraph : replica->m_pGraph;
+            const COMMON::ITerminationPolicy* policy = p_query.GetTerminationPolicy().get();
+            const SearchOptions& options = p_query.GetSearchOptions();
+            const int initialPivots = SearchOptions::Pick(options.m_initialDynamicPivots, m_iNumberOfInitialDynamicPivots);
+            const int otherPivots = SearchOptions::Pick(options.m_otherDynamicPivots, m_iNumberOfOtherDynamicPivots);
+            const IFilter* filter = p_query.GetFilter().get();
+            const SizeType checkBudget = (filter == nullptr) ? MaxSize : filter->CheckBudget(p_space.m_iMaxCheck, m_pSamples.R());
+
+            if (filter != nullptr)
+            {
+                SizeType accepted = filter->AcceptedCount();
+                if (accepted >= 0 && accepted <= p_space.m_iMaxCheck)
+                {
+                    SearchIndexByFilter(p_query, p_space, *filter, p_searchDeleted);
+                }
+                else if (p_searchDuplicated)
+                {
+                    Search(if ((p_searchDeleted || !m_deletedID.Contains(tmpNode)) && filter->Accept(tmpNode)), if (!p_query.AddPoint(tmpNode, gnode.distance)))
+                }
+                else
+                {
+                    Search(if ((p_searchDeleted || !m_deletedID.Contains(tmpNode)) && filter->Accept(tmpNode)), p_query.AddPoint(tmpNode, gnode.distance);)
+                }
+            }
+            else if (m_deletedID.Count() == 0 || p_searchDeleted)
             {
                 if (p_searchDuplicated)
                 {
@@ -276,10 +324,11 @@ namespace SPTAG
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
+            const SearchOptions& options = p_query.GetSearchOptions();
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_iMaxCheck, p_query.GetResultNum());
+            workSpace->Reset(SearchOptions::Pick(options.m_maxCheck, m_iMaxCheck), p_query.GetResultNum());
 
-            SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted, true);
+            SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted || options.m_searchDeleted, true);
 
             m_workSpacePool->Return(workSpace);
 
@@ -294,6 +343,308 @@ namespace SPTAG
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        void Index<T>::SearchIndexByFilter(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, const IFilter& p_filter, bool p_searchDeleted) const
+        {
+            const SizeType end = m_pSamples.R();
+            const int batchSize = 64;
+            p_space.ReserveBatch(batchSize);
+
+            SizeType vid = p_filter.NextAccepted(0, end);
+            while (vid < end)
+            {
+                int batchCount = 0;
+                for (; vid < end && batchCount < batchSize; vid = p_filter.NextAccepted(vid + 1, end))
+                {
+                    if (p_searchDeleted || !m_deletedID.Contains(vid)) p_space.m_batchIDs[batchCount++] = vid;
+                }
+                ComputeDistanceBatch(p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data());
+                for (int i = 0; i < batchCount; i++) p_query.AddPoint(p_space.m_batchIDs[i], p_space.m_batchDists[i]);
+            }
+            p_query.SortResult();
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            p_results.clear();
+            if (p_maxResults <= 0) return ErrorCode::Success;
+
+            COMMON::QueryResultSet<T> query((const T*)p_vector, 1);
+            if (m_pQuantizer) query.SetTarget((const T*)p_vector, m_pQuantizer);
+
+            // Every vector in range is visited, so the visited table is sized for p_maxResults; the budget
+            // for nodes out of range stays at MaxCheck.
+            auto workSpace = m_workSpacePool->Rent();
+            workSpace->Reset(max(m_iMaxCheck, min(p_maxResults, (int)m_pSamples.R())), 1);
+            workSpace->m_iMaxCheck = m_iMaxCheck;
+
+            SearchIndexRange(query, *workSpace, p_radius, p_maxResults, p_results, p_searchDeleted);
+
+            m_workSpacePool->Return(workSpace);
+
+            std::sort(p_results.begin(), p_results.end(), COMMON::Compare);
+            if (p_withMeta && nullptr != m_pMetadata)
+            {
+                for (BasicResult& res : p_results) res.Meta = m_pMetadata->GetMetadataCopy(res.VID);
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        void Index<T>::SearchIndexRange(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_searchDeleted) const
+        {
+            std::shared_ptr<NumaReplicaSet> replicas = std::atomic_load(&m_pNumaReplicas);
+            const NumaReplica* replica = LocalReplica(replicas);
+            const COMMON::Dataset<T>& samples = (replica == nullptr) ? m_pSamples : replica->m_pSamples;
+            const COMMON::BKTree& trees = (replica == nullptr) ? m_pTrees : replica->m_pTrees;
+            const COMMON::RelativeNeighborhoodGraph& graph = (replica == nullptr) ? m_pGraph : replica->m_pGraph;
+            const bool checkDeleted = !p_searchDeleted && m_deletedID.Count() > 0;
+
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            trees.InitSearchTrees(samples, m_fComputeDistance, p_query, p_space);
+            trees.SearchTrees(samples, m_fComputeDistance, p_query, p_space, m_iNumberOfInitialDynamicPivots);
+            const DimensionType checkPos = graph.m_iNeighborhoodSize - 1;
+            p_space.ReserveBatch(checkPos + 1);
+            while (!p_space.m_NGQueue.empty())
+            {
+                NodeDistPair gnode = p_space.m_NGQueue.pop();
+                SizeType tmpNode = gnode.node;
+                const SizeType* node = graph[tmpNode];
+                _mm_prefetch((const char*)node, _MM_HINT_T0);
+                if (gnode.distance <= p_radius)
+                {
+                    SizeType checkNode = node[checkPos];
+                    if (checkNode < -1)
+                    {
+                        // The duplicates of this vector hang off its tree node and are all in range.
+                        const COMMON::BKTNode& tnode = trees[-2 - checkNode];
+                        SizeType i = -tnode.childStart;
+                        do {
+                            if (!checkDeleted || !m_deletedID.Contains(tmpNode)) p_results.emplace_back(tmpNode, gnode.distance);
+                            tmpNode = trees[i].centerid;
+                        } while (i++ < tnode.childEnd && (int)p_results.size() < p_maxResults);
+                    }
+                    else if (!checkDeleted || !m_deletedID.Contains(tmpNode))
+                    {
+                        p_results.emplace_back(tmpNode, gnode.distance);
+                    }
+                    if ((int)p_results.size() >= p_maxResults) return;
+                }
+                else if (gnode.distance > p_space.m_Results.worst() || p_space.m_iNumberOfCheckedLeaves > p_space.m_iMaxCheck)
+                {
+                    return;
+                }
+
+                int batchCount = 0;
+                for (DimensionType i = 0; i <= checkPos; i++)
+                {
+                    SizeType nn_index = node[i];
+                    if (nn_index < 0) break;
+                    if (p_space.CheckAndSet(nn_index)) continue;
+                    p_space.m_batchIDs[batchCount++] = nn_index;
+                }
+                ComputeDistanceBatch(samples, p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data());
+                for (int i = 0; i < batchCount; i++)
+                {
+                    float distance2leaf = p_space.m_batchDists[i];
+                    p_space.m_iNumberOfCheckedLeaves++;
+                    // Nodes in range are always expanded; the others only while they are among the closest seen.
+                    if (distance2leaf <= p_radius || p_space.m_Results.insert(distance2leaf))
+                    {
+                        p_space.m_NGQueue.insert(NodeDistPair(p_space.m_batchIDs[i], distance2leaf));
+                    }
+                }
+                if (p_space.m_NGQueue.Top().distance > p_space.m_SPTQueue.Top().distance)
+                {
+                    trees.SearchTrees(samples, m_fComputeDistance, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves);
+                }
+            }
+        }
+
+        template <typename T>
+        void Index<T>::SearchIndexBatch(std::vector<COMMON::QueryResultSet<T>*>& p_queries, std::vector<COMMON::WorkSpace*>& p_spaces, bool p_searchDeleted) const
+        {
+            bool checkDeleted = !p_searchDeleted && m_deletedID.Count() > 0;
+            int queryNum = (int)p_queries.size();
+
+            std::shared_ptr<NumaReplicaSet> replicas = std::atomic_load(&m_pNumaReplicas);
+            const NumaReplica* replica = LocalReplica(replicas);
+            const COMMON::Dataset<T>& samples = (replica == nullptr) ? m_pSamples : replica->m_pSamples;
+            const COMMON::BKTree& trees = (replica == nullptr) ? m_pTrees : replica->m_pTrees;
+            const COMMON::RelativeNeighborhoodGraph& graph = (replica == nullptr) ? m_pGraph : replica->m_pGraph;
+
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            for (int q = 0; q < queryNum; q++)
+            {
+                if (m_pQuantizer && !p_queries[q]->HasQuantizedTarget())
+                {
+                    p_queries[q]->SetTarget(p_queries[q]->GetTarget(), m_pQuantizer);
+                }
+                trees.InitSearchTrees(samples, m_fComputeDistance, *p_queries[q], *p_spaces[q]);
+                trees.SearchTrees(samples, m_fComputeDistance, *p_queries[q], *p_spaces[q], m_iNumberOfInitialDynamicPivots);
+            }
+
+            const DimensionType checkPos = graph.m_iNeighborhoodSize - 1;
+            std::vector<int> active(queryNum), expanding;
+            for (int q = 0; q < queryNum; q++) active[q] = q;
+            expanding.reserve(queryNum);
+            std::vector<const SizeType*> expandNodes(queryNum);
+            // (neighbor id, query slot) pairs of one round in the order a single query search would visit them,
+            // plus a permutation grouping them by neighbor id so that every row is fetched once per round.
+            std::vector<std::pair<SizeType, int>> candidates;
+            std::vector<float> candidateDists;
+            std::vector<int> order;
+            candidates.reserve((size_t)queryNum * (checkPos + 1));
+
+            while (!active.empty())
+            {
+                expanding.clear();
+                for (int q : active)
+                {
+                    COMMON::QueryResultSet<T>& p_query = *p_queries[q];
+                    COMMON::WorkSpace& p_space = *p_spaces[q];
+                    if (p_space.m_NGQueue.empty())
+                    {
+                        p_query.SortResult();
+                        continue;
+                    }
+
+                    NodeDistPair gnode = p_space.m_NGQueue.pop();
+                    SizeType tmpNode = gnode.node;
+                    const SizeType* node = graph[tmpNode];
+                    _mm_prefetch((const char*)node, _MM_HINT_T0);
+                    if (gnode.distance <= p_query.worstDist())
+                    {
+                        SizeType checkNode = node[checkPos];
+                        if (checkNode < -1)
+                        {
+                            const COMMON::BKTNode& tnode = trees[-2 - checkNode];
+                            SizeType i = -tnode.childStart;
+                            do {
+                                if (!checkDeleted || !m_deletedID.Contains(tmpNode))
+                                {
+                                    if (!p_query.AddPoint(tmpNode, gnode.distance)) break;
+                                }
+                                tmpNode = trees[i].centerid;
+                            } while (i++ < tnode.childEnd);
+                        }
+                        else if (!checkDeleted || !m_deletedID.Contains(tmpNode))
+                        {
+                            p_query.AddPoint(tmpNode, gnode.distance);
+                        }
+                    }
+                    else if (!checkDeleted || !m_deletedID.Contains(tmpNode))
+                    {
+                        if (gnode.distance > p_space.m_Results.worst() || p_space.m_iNumberOfCheckedLeaves > p_space.m_iMaxCheck)
+                        {
+                            p_query.SortResult();
+                            continue;
+                        }
+                    }
+                    expandNodes[q] = node;
+                    expanding.push_back(q);
+                }
+
+                candidates.clear();
+                for (int q : expanding)
+                {
+                    const SizeType* node = expandNodes[q];
+                    COMMON::WorkSpace& p_space = *p_spaces[q];
+                    for (DimensionType i = 0; i <= checkPos; i++)
+                    {
+                        SizeType nn_index = node[i];
+                        if (nn_index < 0) break;
+                        if (p_space.CheckAndSet(nn_index)) continue;
+                        p_space.m_iNumberOfCheckedLeaves++;
+                        candidates.emplace_back(nn_index, q);
+                    }
+                }
+                candidateDists.resize(candidates.size());
+                order.resize(candidates.size());
+                for (int j = 0; j < (int)order.size(); j++) order[j] = j;
+                std::sort(order.begin(), order.end(), [&candidates](int a, int b) { return candidates[a] < candidates[b]; });
+
+                for (size_t j = 0; j < order.size();)
+                {
+                    SizeType nn_index = candidates[order[j]].first;
+                    const T* row = samples[nn_index];
+                    size_t next = j;
+                    while (next < order.size() && candidates[order[next]].first == nn_index) next++;
+                    if (next < order.size()) _mm_prefetch((const char*)samples[candidates[order[next]].first], _MM_HINT_T0);
+                    for (; j < next; j++)
+                    {
+                        candidateDists[order[j]] = m_fComputeDistance(p_queries[candidates[order[j]].second]->GetQuantizedTarget(), row, GetFeatureDim());
+                    }
+                }
+
+                for (size_t j = 0; j < candidates.size(); j++)
+                {
+                    COMMON::WorkSpace& p_space = *p_spaces[candidates[j].second];
+                    if (p_space.m_Results.insert(candidateDists[j]))
+                    {
+                        p_space.m_NGQueue.insert(NodeDistPair(candidates[j].first, candidateDists[j]));
+                    }
+                }
+
+                for (int q : expanding)
+                {
+                    COMMON::WorkSpace& p_space = *p_spaces[q];
+                    if (p_space.m_NGQueue.Top().distance > p_space.m_SPTQueue.Top().distance)
+                    {
+                        trees.SearchTrees(samples, m_fComputeDistance, *p_queries[q], p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves);
+                    }
+                }
+                active.swap(expanding);
+            }
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const
+        {
+            if (m_iBatchSearchSize <= 1) return VectorIndex::SearchIndex(p_vector, p_vectorCount, p_neighborCount, p_withMeta, p_results);
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            int groupNum = (p_vectorCount + m_iBatchSearchSize - 1) / m_iBatchSearchSize;
+#pragma omp parallel for schedule(dynamic)
+            for (int g = 0; g < groupNum; g++)
+            {
+                int begin = g * m_iBatchSearchSize, end = min(begin + m_iBatchSearchSize, p_vectorCount);
+                std::vector<QueryResult> queries;
+                std::vector<std::shared_ptr<COMMON::WorkSpace>> workSpaces;
+                std::vector<COMMON::QueryResultSet<T>*> queryPtrs;
+                std::vector<COMMON::WorkSpace*> spacePtrs;
+                queries.reserve(end - begin);
+                for (int i = begin; i < end; i++)
+                {
+                    queries.emplace_back((const T*)p_vector + (size_t)i * GetFeatureDim(), p_neighborCount, p_withMeta, p_results + (size_t)i * p_neighborCount);
+                    workSpaces.push_back(m_workSpacePool->Rent());
+                    workSpaces.back()->Reset(m_iMaxCheck, p_neighborCount);
+                    queryPtrs.push_back((COMMON::QueryResultSet<T>*)&queries.back());
+                    spacePtrs.push_back(workSpaces.back().get());
+                }
+
+                SearchIndexBatch(queryPtrs, spacePtrs, false);
+
+                for (auto& workSpace : workSpaces) m_workSpacePool->Return(workSpace);
+
+                if (p_withMeta && nullptr != m_pMetadata)
+                {
+                    for (auto& query : queries)
+                    {
+                        for (int i = 0; i < query.GetResultNum(); ++i)
+                        {
+                            SizeType result = query.GetResult(i)->VID;
+                            query.SetMetadata(i, (result < 0) ? ByteArray::c_empty : m_pMetadata->GetMetadataCopy(result));
+                        }
+                    }
+                }
+            }
+            return ErrorCode::Success;
+        }
+
         template<typename T>
         ErrorCode Index<T>::RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
@@ -334,8 +685,10 @@ namespace SPTAG
 
             omp_set_num_threads(m_iNumberOfThreads);
 
+            SelectHugePages();
             m_pSamples.Initialize(p_vectorNum, p_dimension, m_iDataBlockSize, m_iDataCapacity, (T*)p_data, p_shareOwnership);
             m_deletedID.Initialize(p_vectorNum, m_iDataBlockSize, m_iDataCapacity);
+            SelectDistanceFunction();
 
             if (DistCalcMethod::Cosine == m_iDistCalcMethod && !p_normalized)
             {
@@ -347,23 +700,130 @@ namespace SPTAG
             }
 
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
 
-            auto t1 = std::chrono::high_resolution_clock::now();
-            m_pTrees.BuildTrees<T>(m_pSamples, m_iDistCalcMethod, m_iNumberOfThreads);
-            auto t2 = std::chrono::high_resolution_clock::now();
-            LOG(Helper::LogLevel::LL_Info, "Build Tree time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t2 - t1).count());
-            
-            m_pGraph.BuildGraph<T>(this, &(m_pTrees.GetSampleMap()));
+            if (DistCalcMethod::InnerProduct == m_iDistCalcMethod && m_bMIPSTransform && !m_pQuantizer)
+            {
+                ErrorCode ret = BuildMIPSStructures();
+                if (ret != ErrorCode::Success) return ret;
+            }
+            else
+            {
+                auto t1 = std::chrono::high_resolution_clock::now();
+                m_pTrees.BuildTrees<T>(m_pSamples, m_iDistCalcMethod, m_iNumberOfThreads);
+                auto t2 = std::chrono::high_resolution_clock::now();
+                LOG(Helper::LogLevel::LL_Info, "Build Tree time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t2 - t1).count());
+
+                m_pGraph.BuildGraph<T>(this, &(m_pTrees.GetSampleMap()));
 
-            auto t3 = std::chrono::high_resolution_clock::now();
-            LOG(Helper::LogLevel::LL_Info, "Build Graph time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t3 - t2).count());
+                auto t3 = std::chrono::high_resolution_clock::now();
+                LOG(Helper::LogLevel::LL_Info, "Build Graph time (s): %lld\n", std::chrono::duration_cast<std::chrono::seconds>(t3 - t2).count());
+            }
 
+            PlaceOnNuma();
             m_bReady = true;
             return ErrorCode::Success;
         }
 
+        // Inner product is not a metric, so the tree and the graph are built over the augmented vectors
+        // [x, sqrt(M^2 - |x|^2)] with L2, M being the largest norm. For a query [q, 0] the augmented L2
+        // distance is |q|^2 + M^2 - 2q.x, which orders the rows exactly like -q.x, so the structures are
+        // then searched with the inner product kernels on the original vectors.
+        template <typename T>
+        ErrorCode Index<T>::BuildMIPSStructures()
+        {
+            SizeType n = GetNumSamples();
+            DimensionType dim = GetFeatureDim();
+
+            std::vector<float> squares(n);
+#pragma omp parallel for
+            for (SizeType i = 0; i < n; i++) {
+                const T* v = m_pSamples[i];
+                float square = 0;
+                for (DimensionType j = 0; j < dim; j++) square += (float)v[j] * (float)v[j];
+                squares[i] = square;
+            }
+            float maxSquare = *std::max_element(squares.begin(), squares.end());
+            LOG(Helper::LogLevel::LL_Info, "MIPS transform: max squared norm %f\n", maxSquare);
+
+            std::vector<float> augmented(((size_t)n) * (dim + 1));
+#pragma omp parallel for
+            for (SizeType i = 0; i < n; i++) {
+                const T* v = m_pSamples[i];
+                float* row = augmented.data() + ((size_t)i) * (dim + 1);
+                for (DimensionType j = 0; j < dim; j++) row[j] = (float)v[j];
+                row[dim] = std::sqrt(max(maxSquare - squares[i], 0.0f));
+            }
+
+            Index<float> builder;
+#define DefineBKTParameter(VarName, VarType, DefaultValue, RepresentStr) \
+            builder.VarName = VarName; \
+
+#include "inc/Core/BKT/ParameterDefinitionList.h"
+#undef DefineBKTParameter
+            builder.m_iDistCalcMethod = DistCalcMethod::L2;
+            builder.m_bMIPSTransform = false;
+
+            ErrorCode ret = builder.BuildIndex(augmented.data(), n, dim + 1, true, true);
+            if (ret != ErrorCode::Success) return ret;
+
+            m_pTrees.Swap(builder.m_pTrees);
+            m_pGraph.CopyFrom(builder.m_pGraph, m_iDataBlockSize, m_iDataCapacity);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        SizeType Index<T>::GetRefineOrder(std::vector<SizeType>& indices, std::vector<SizeType>& reverseIndices) const
+        {
+            SizeType newR = GetNumSamples();
+            reverseIndices.resize(newR);
+            if (!m_bGraphReorder)
+            {
+                for (SizeType i = 0; i < newR; i++) {
+                    if (!m_deletedID.Contains(i)) {
+                        indices.push_back(i);
+                        reverseIndices[i] = i;
+                    }
+                    else {
+                        while (m_deletedID.Contains(newR - 1) && newR > i) newR--;
+                        if (newR == i) break;
+                        indices.push_back(newR - 1);
+                        reverseIndices[newR - 1] = i;
+                        newR--;
+                    }
+                }
+                return newR;
+            }
+
+            // Number the tree centers first, top level down, since every query starts from them,
+            // then walk the graph breadth first so that rows expanded together are stored together.
+            std::vector<bool> visited(newR, false);
+            auto visit = [&](SizeType node) {
+                if (node < 0 || node >= newR || visited[node] || m_deletedID.Contains(node)) return;
+                visited[node] = true;
+                reverseIndices[node] = (SizeType)indices.size();
+                indices.push_back(node);
+            };
+            size_t head = 0;
+            auto expand = [&]() {
+                for (; head < indices.size(); head++) {
+                    const SizeType* row = m_pGraph[indices[head]];
+                    for (DimensionType j = 0; j < m_pGraph.m_iNeighborhoodSize && row[j] >= 0; j++) visit(row[j]);
+                }
+            };
+
+            for (SizeType i = 0; i < m_pTrees.size(); i++) visit(m_pTrees[i].centerid);
+            expand();
+            for (SizeType i = 0; i < newR; i++) {
+                visit(i);
+                expand();
+            }
+
+            LOG(Helper::LogLevel::LL_Info, "Reorder %d vectors breadth first from the tree centers\n", (SizeType)indices.size());
+            return (SizeType)indices.size();
+        }
+
         template <typename T>
         ErrorCode Index<T>::RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex)
         {
@@ -379,33 +839,21 @@ namespace SPTAG
             std::lock_guard<std::mutex> lock(m_dataAddLock);
             std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
 
-            SizeType newR = GetNumSamples();
-
             std::vector<SizeType> indices;
-            std::vector<SizeType> reverseIndices(newR);
-            for (SizeType i = 0; i < newR; i++) {
-                if (!m_deletedID.Contains(i)) {
-                    indices.push_back(i);
-                    reverseIndices[i] = i;
-                }
-                else {
-                    while (m_deletedID.Contains(newR - 1) && newR > i) newR--;
-                    if (newR == i) break;
-                    indices.push_back(newR - 1);
-                    reverseIndices[newR - 1] = i;
-                    newR--;
-                }
-            }
+            std::vector<SizeType> reverseIndices;
+            SizeType newR = GetRefineOrder(indices, reverseIndices);
 
             LOG(Helper::LogLevel::LL_Info, "Refine... from %d -> %d\n", GetNumSamples(), newR);
             if (newR == 0) return ErrorCode::EmptyIndex;
 
             ptr->m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            ptr->m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            ptr->m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             ptr->m_threadPool.init();
 
             ErrorCode ret = ErrorCode::Success;
+            ptr->SelectHugePages();
             if ((ret = m_pSamples.Refine(indices, ptr->m_pSamples)) != ErrorCode::Success) return ret;
+            ptr->SelectDistanceFunction();
             if (nullptr != m_pMetadata && (ret = m_pMetadata->RefineMetadata(indices, ptr->m_pMetadata, m_iDataBlockSize, m_iDataCapacity, m_iMetaRecordSize)) != ErrorCode::Success) return ret;
 
             ptr->m_deletedID.Initialize(newR, m_iDataBlockSize, m_iDataCapacity);
@@ -413,6 +861,7 @@ namespace SPTAG
             (*newtree).BuildTrees<T>(ptr->m_pSamples, ptr->m_iDistCalcMethod, omp_get_num_threads());
             m_pGraph.RefineGraph<T>(this, indices, reverseIndices, nullptr, &(ptr->m_pGraph), &(ptr->m_pTrees.GetSampleMap()));
             if (HasMetaMapping()) ptr->BuildMetaMapping(false);
+            ptr->PlaceOnNuma();
             ptr->m_bReady = true;
             return ret;
         }
@@ -423,23 +872,9 @@ namespace SPTAG
             std::lock_guard<std::mutex> lock(m_dataAddLock);
             std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
 
-            SizeType newR = GetNumSamples();
-
             std::vector<SizeType> indices;
-            std::vector<SizeType> reverseIndices(newR);
-            for (SizeType i = 0; i < newR; i++) {
-                if (!m_deletedID.Contains(i)) {
-                    indices.push_back(i);
-                    reverseIndices[i] = i;
-                }
-                else {
-                    while (m_deletedID.Contains(newR - 1) && newR > i) newR--;
-                    if (newR == i) break;
-                    indices.push_back(newR - 1);
-                    reverseIndices[newR - 1] = i;
-                    newR--;
-                }
-            }
+            std::vector<SizeType> reverseIndices;
+            SizeType newR = GetRefineOrder(indices, reverseIndices);
 
             LOG(Helper::LogLevel::LL_Info, "Refine... from %d -> %d\n", GetNumSamples(), newR);
             if (newR == 0) return ErrorCode::EmptyIndex;
@@ -518,6 +953,11 @@ namespace SPTAG
 
                 if (p_dimension != GetFeatureDim()) return ErrorCode::DimensionSizeMismatch;
 
+                if (std::atomic_load(&m_pNumaReplicas) != nullptr) {
+                    std::atomic_store(&m_pNumaReplicas, std::shared_ptr<NumaReplicaSet>());
+                    LOG(Helper::LogLevel::LL_Info, "Dropped the NUMA replicas for the update, UpdateIndex copies them again.\n");
+                }
+
                 if (m_pSamples.AddBatch((const T*)p_data, p_vectorNum) != ErrorCode::Success || 
                     m_pGraph.AddBatch(p_vectorNum) != ErrorCode::Success || 
                     m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success) {
@@ -564,13 +1004,63 @@ namespace SPTAG
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        void Index<T>::PlaceOnNuma()
+        {
+            std::atomic_store(&m_pNumaReplicas, std::shared_ptr<NumaReplicaSet>());
+            if (m_iNumaMode == 1)
+            {
+                if (!m_pSamples.PlaceOnNuma(-1) || !m_pGraph.PlaceOnNuma(-1) || !m_deletedID.PlaceOnNuma(-1))
+                    LOG(Helper::LogLevel::LL_Warning, "Cannot interleave the index over the NUMA nodes, keeping first touch placement.\n");
+                return;
+            }
+            if (m_iNumaMode != 2) return;
+
+            // Each replica is copied by a thread pinned to its node, so that even the
+            // structures without an explicit binding (the tree nodes) are touched locally.
+            int nodes = Helper::Numa::NodeCount();
+            std::shared_ptr<NumaReplicaSet> replicas(new NumaReplicaSet(nodes));
+            std::vector<SizeType> indices(GetNumSamples());
+            for (SizeType i = 0; i < (SizeType)indices.size(); i++) indices[i] = i;
+
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            std::vector<std::thread> threads;
+            for (int node = 0; node < nodes; node++)
+            {
+                threads.emplace_back([&, node]() {
+                    if (!Helper::Numa::PinThread(node))
+                        LOG(Helper::LogLevel::LL_Warning, "Cannot pin to NUMA node %d, its replica may be allocated remotely.\n", node);
+
+                    std::unique_ptr<NumaReplica> replica(new NumaReplica(m_pTrees));
+                    replica->m_pSamples.SetHugePages((Helper::HugePageMode)m_iHugePages);
+                    replica->m_pGraph.SetHugePages((Helper::HugePageMode)m_iHugePages);
+                    m_pSamples.Refine(indices, replica->m_pSamples);
+                    m_pTrees.CopyTo(replica->m_pTrees);
+                    m_pGraph.CopyTo(replica->m_pGraph);
+                    replica->m_pSamples.PlaceOnNuma(node);
+                    replica->m_pGraph.PlaceOnNuma(node);
+                    (*replicas)[node] = std::move(replica);
+                });
+            }
+            for (auto& thread : threads) thread.join();
+
+            LOG(Helper::LogLevel::LL_Info, "Replicated %d vectors on %d NUMA nodes.\n", GetNumSamples(), nodes);
+            std::atomic_store(&m_pNumaReplicas, replicas);
+        }
+
         template <typename T>
         ErrorCode
             Index<T>::UpdateIndex()
         {
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
+            if (m_bReady)
+            {
+                std::lock_guard<std::mutex> lock(m_dataAddLock);
+                PlaceOnNuma();
+            }
             return ErrorCode::Success;
         }
 
@@ -595,7 +1085,7 @@ namespace SPTAG
 #undef DefineBKTParameter
 
             if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "DistCalcMethod")) {
-                m_fComputeDistance = m_pQuantizer ? m_pQuantizer->DistanceCalcSelector<T>(m_iDistCalcMethod) : COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
+                SelectDistanceFunction();
                 auto base = m_pQuantizer ? m_pQuantizer->GetBase() : COMMON::Utils::GetBase<T>();
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? base * base : 1;
             }
@@ -682,7 +682,7 @@ float DistanceUtils::ComputeL2Distance_AVX512(const float* pX, const float* pY,
     return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_SSE(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
+inline float ComputeDotProduct_SSE(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
 {
     const std::int8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::int8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -707,10 +707,10 @@ float DistanceUtils::ComputeCosineDistance_SSE(const std::int8_t* pX, const std:
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 16129 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
 {
     const std::int8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::int8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -735,10 +735,10 @@ float DistanceUtils::ComputeCosineDistance_AVX(const std::int8_t* pX, const std:
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 16129 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX512(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX512(const std::int8_t* pX, const std::int8_t* pY, DimensionType length)
 {
     const std::int8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::int8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -773,10 +773,10 @@ float DistanceUtils::ComputeCosineDistance_AVX512(const std::int8_t* pX, const s
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 16129 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_SSE(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
+inline float ComputeDotProduct_SSE(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
 {
     const std::uint8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::uint8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -801,10 +801,10 @@ float DistanceUtils::ComputeCosineDistance_SSE(const std::uint8_t* pX, const std
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 65025 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
 {
     const std::uint8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::uint8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -829,10 +829,10 @@ float DistanceUtils::ComputeCosineDistance_AVX(const std::uint8_t* pX, const std
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 65025 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX512(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX512(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length)
 {
     const std::uint8_t* pEnd32 = pX + ((length >> 5) << 5);
     const std::uint8_t* pEnd16 = pX + ((length >> 4) << 4);
@@ -867,10 +867,10 @@ float DistanceUtils::ComputeCosineDistance_AVX512(const std::uint8_t* pX, const
         c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
     }
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return 65025 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+inline float ComputeDotProduct_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
 {
     const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
     const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
@@ -896,10 +896,10 @@ float DistanceUtils::ComputeCosineDistance_SSE(const std::int16_t* pX, const std
     }
 
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return  1073676289 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
 {
     const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
     const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
@@ -925,10 +925,10 @@ float DistanceUtils::ComputeCosineDistance_AVX(const std::int16_t* pX, const std
     }
 
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return  1073676289 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+inline float ComputeDotProduct_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
 {
     const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
     const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
@@ -964,10 +964,10 @@ float DistanceUtils::ComputeCosineDistance_AVX512(const std::int16_t* pX, const
     }
 
     while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-    return  1073676289 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_SSE(const float* pX, const float* pY, DimensionType length)
+inline float ComputeDotProduct_SSE(const float* pX, const float* pY, DimensionType length)
 {
     const float* pEnd16 = pX + ((length >> 4) << 4);
     const float* pEnd4 = pX + ((length >> 2) << 2);
@@ -988,10 +988,10 @@ float DistanceUtils::ComputeCosineDistance_SSE(const float* pX, const float* pY,
     float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
 
     while (pX < pEnd1) diff += (*pX++) * (*pY++);
-    return 1 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX(const float* pX, const float* pY, DimensionType length)
+inline float ComputeDotProduct_AVX(const float* pX, const float* pY, DimensionType length)
 {
     const float* pEnd16 = pX + ((length >> 4) << 4);
     const float* pEnd4 = pX + ((length >> 2) << 2);
@@ -1011,10 +1011,10 @@ float DistanceUtils::ComputeCosineDistance_AVX(const float* pX, const float* pY,
     float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
 
     while (pX < pEnd1) diff += (*pX++) * (*pY++);
-    return 1 - diff;
+    return diff;
 }
 
-float DistanceUtils::ComputeCosineDistance_AVX512(const float* pX, const float* pY, DimensionType length)
+inline float ComputeDotProduct_AVX512(const float* pX, const float* pY, DimensionType length)
 {
     const float* pEnd8 = pX + ((length >> 3) << 3);
     const float* pEnd4 = pX + ((length >> 2) << 2);
@@ -1043,5 +1043,1114 @@ float DistanceUtils::ComputeCosineDistance_AVX512(const float* pX, const float*
     float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
 
     while (pX < pEnd1) diff += (*pX++) * (*pY++);
-    return 1 - diff;
+    return diff;
+}
+
+// Cosine distances take base^2 - x.y on normalized vectors, inner product distances -x.y on raw ones.
+// Both share the dot product kernels above, so they stay bit-identical up to the final subtraction.
+#define DefineDotProductKernels(Level, Type) \
+float DistanceUtils::ComputeCosineDistance_##Level(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return Utils::GetBase<Type>() * Utils::GetBase<Type>() - ComputeDotProduct_##Level(pX, pY, length); \
+} \
+float DistanceUtils::ComputeInnerProductDistance_##Level(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return -ComputeDotProduct_##Level(pX, pY, length); \
+} \
+
+DefineDotProductKernels(SSE, std::int8_t)
+DefineDotProductKernels(AVX, std::int8_t)
+DefineDotProductKernels(AVX512, std::int8_t)
+DefineDotProductKernels(SSE, std::uint8_t)
+DefineDotProductKernels(AVX, std::uint8_t)
+DefineDotProductKernels(AVX512, std::uint8_t)
+DefineDotProductKernels(SSE, std::int16_t)
+DefineDotProductKernels(AVX, std::int16_t)
+DefineDotProductKernels(AVX512, std::int16_t)
+DefineDotProductKernels(SSE, float)
+DefineDotProductKernels(AVX, float)
+DefineDotProductKernels(AVX512, float)
+#undef DefineDotProductKernels
+
+inline float _mm_hsum_ps(__m128 X)
+{
+    float f[4];
+    _mm_storeu_ps(f, X);
+    return f[0] + f[1] + f[2] + f[3];
+}
+
+struct L2Op
+{
+    static inline __m128 exec(__m128 X, __m128 Y) { return _mm_sqdf_ps(X, Y); }
+    static inline __m256 exec(__m256 X, __m256 Y) { return _mm256_sqdf_ps(X, Y); }
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+    static inline __m512 exec(__m512 X, __m512 Y) { return _mm512_sqdf_ps(X, Y); }
+#endif
+    static inline float exec(float x, float y) { float c1 = x - y; return c1 * c1; }
+    static inline float finish(float diff) { return diff; }
+};
+
+struct CosineOp
+{
+    static inline __m128 exec(__m128 X, __m128 Y) { return _mm_mul_ps(X, Y); }
+    static inline __m256 exec(__m256 X, __m256 Y) { return _mm256_mul_ps(X, Y); }
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+    static inline __m512 exec(__m512 X, __m512 Y) { return _mm512_mul_ps(X, Y); }
+#endif
+    static inline float exec(float x, float y) { return x * y; }
+    static inline float finish(float diff) { return 1 - diff; }
+};
+
+struct InnerProductOp : CosineOp
+{
+    static inline float finish(float diff) { return -diff; }
+};
+
+// Four rows share every query load. The per-row accumulation order is the same as in the
+// single pair kernels, so batch and single distances are bit-identical.
+#define REPEAT4(type, load, delta, acc, result) \
+            { \
+                type c = load(pX + i); \
+                result##0 = acc(result##0, Op::exec(c, load(pY[0] + i))); \
+                result##1 = acc(result##1, Op::exec(c, load(pY[1] + i))); \
+                result##2 = acc(result##2, Op::exec(c, load(pY[2] + i))); \
+                result##3 = acc(result##3, Op::exec(c, load(pY[3] + i))); \
+                i += delta; \
+            } \
+
+#define TAIL4(result) \
+            pDist[0] = result##0; pDist[1] = result##1; pDist[2] = result##2; pDist[3] = result##3; \
+            for (; i < length; i++) { \
+                pDist[0] += Op::exec(pX[i], pY[0][i]); \
+                pDist[1] += Op::exec(pX[i], pY[1][i]); \
+                pDist[2] += Op::exec(pX[i], pY[2][i]); \
+                pDist[3] += Op::exec(pX[i], pY[3][i]); \
+            } \
+            for (int r = 0; r < 4; r++) pDist[r] = Op::finish(pDist[r]); \
+
+template <typename Op>
+inline void ComputeBatch4_SSE(const float* pX, const float* const* pY, DimensionType length, float* pDist)
+{
+    DimensionType i = 0, end16 = ((length >> 4) << 4), end4 = ((length >> 2) << 2);
+    __m128 d0 = _mm_setzero_ps(), d1 = _mm_setzero_ps(), d2 = _mm_setzero_ps(), d3 = _mm_setzero_ps();
+    while (i < end16)
+    {
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, d)
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, d)
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, d)
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, d)
+    }
+    while (i < end4)
+    {
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, d)
+    }
+    float s0 = _mm_hsum_ps(d0), s1 = _mm_hsum_ps(d1), s2 = _mm_hsum_ps(d2), s3 = _mm_hsum_ps(d3);
+    TAIL4(s)
+}
+
+template <typename Op>
+inline void ComputeBatch4_AVX(const float* pX, const float* const* pY, DimensionType length, float* pDist)
+{
+    DimensionType i = 0, end16 = ((length >> 4) << 4), end4 = ((length >> 2) << 2);
+    __m256 d0 = _mm256_setzero_ps(), d1 = _mm256_setzero_ps(), d2 = _mm256_setzero_ps(), d3 = _mm256_setzero_ps();
+    while (i < end16)
+    {
+        REPEAT4(__m256, _mm256_loadu_ps, 8, _mm256_add_ps, d)
+        REPEAT4(__m256, _mm256_loadu_ps, 8, _mm256_add_ps, d)
+    }
+    __m128 e0 = _mm_add_ps(_mm256_castps256_ps128(d0), _mm256_extractf128_ps(d0, 1));
+    __m128 e1 = _mm_add_ps(_mm256_castps256_ps128(d1), _mm256_extractf128_ps(d1, 1));
+    __m128 e2 = _mm_add_ps(_mm256_castps256_ps128(d2), _mm256_extractf128_ps(d2, 1));
+    __m128 e3 = _mm_add_ps(_mm256_castps256_ps128(d3), _mm256_extractf128_ps(d3, 1));
+    while (i < end4)
+    {
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, e)
+    }
+    float s0 = _mm_hsum_ps(e0), s1 = _mm_hsum_ps(e1), s2 = _mm_hsum_ps(e2), s3 = _mm_hsum_ps(e3);
+    TAIL4(s)
+}
+
+template <typename Op>
+inline void ComputeBatch4_AVX512(const float* pX, const float* const* pY, DimensionType length, float* pDist)
+{
+    DimensionType i = 0, end8 = ((length >> 3) << 3), end4 = ((length >> 2) << 2);
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+    DimensionType end16 = ((length >> 4) << 4);
+    __m512 f0 = _mm512_setzero_ps(), f1 = _mm512_setzero_ps(), f2 = _mm512_setzero_ps(), f3 = _mm512_setzero_ps();
+    while (i < end16)
+    {
+        REPEAT4(__m512, _mm512_loadu_ps, 16, _mm512_add_ps, f)
+    }
+    __m256 d0 = _mm256_add_ps(_mm512_castps512_ps256(f0), _mm512_extractf32x8_ps(f0, 1));
+    __m256 d1 = _mm256_add_ps(_mm512_castps512_ps256(f1), _mm512_extractf32x8_ps(f1, 1));
+    __m256 d2 = _mm256_add_ps(_mm512_castps512_ps256(f2), _mm512_extractf32x8_ps(f2, 1));
+    __m256 d3 = _mm256_add_ps(_mm512_castps512_ps256(f3), _mm512_extractf32x8_ps(f3, 1));
+#else
+    __m256 d0 = _mm256_setzero_ps(), d1 = _mm256_setzero_ps(), d2 = _mm256_setzero_ps(), d3 = _mm256_setzero_ps();
+#endif
+    while (i < end8)
+    {
+        REPEAT4(__m256, _mm256_loadu_ps, 8, _mm256_add_ps, d)
+    }
+    __m128 e0 = _mm_add_ps(_mm256_castps256_ps128(d0), _mm256_extractf128_ps(d0, 1));
+    __m128 e1 = _mm_add_ps(_mm256_castps256_ps128(d1), _mm256_extractf128_ps(d1, 1));
+    __m128 e2 = _mm_add_ps(_mm256_castps256_ps128(d2), _mm256_extractf128_ps(d2, 1));
+    __m128 e3 = _mm_add_ps(_mm256_castps256_ps128(d3), _mm256_extractf128_ps(d3, 1));
+    while (i < end4)
+    {
+        REPEAT4(__m128, _mm_loadu_ps, 4, _mm_add_ps, e)
+    }
+    float s0 = _mm_hsum_ps(e0), s1 = _mm_hsum_ps(e1), s2 = _mm_hsum_ps(e2), s3 = _mm_hsum_ps(e3);
+    TAIL4(s)
+}
+
+template <void(*batch4)(const float*, const float* const*, DimensionType, float*), float(*func)(const float*, const float*, DimensionType)>
+inline void ComputeFloatBatch(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        for (int j = i + 4; j < i + 8 && j < count; j++) _mm_prefetch((const char*)pY[j], _MM_HINT_T0);
+        batch4(pX, pY + i, length, pDist + i);
+    }
+    for (; i < count; i++) pDist[i] = func(pX, pY[i], length);
+}
+
+template <typename T, float(*func)(const T*, const T*, DimensionType)>
+inline void ComputeBatch(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (i + 2 < count) _mm_prefetch((const char*)pY[i + 2], _MM_HINT_T0);
+        pDist[i] = func(pX, pY[i], length);
+    }
+}
+
+#define DefineBatchKernel(Method, Level, Type) \
+void DistanceUtils::Compute##Method##DistanceBatch_##Level(const Type* pX, const Type* const* pY, int count, DimensionType length, float* pDist) \
+{ \
+    ComputeBatch<Type, DistanceUtils::Compute##Method##Distance_##Level>(pX, pY, count, length, pDist); \
+} \
+
+DefineBatchKernel(L2, SSE, std::int8_t)
+DefineBatchKernel(L2, AVX, std::int8_t)
+DefineBatchKernel(L2, AVX512, std::int8_t)
+DefineBatchKernel(L2, SSE, std::uint8_t)
+DefineBatchKernel(L2, AVX, std::uint8_t)
+DefineBatchKernel(L2, AVX512, std::uint8_t)
+DefineBatchKernel(L2, SSE, std::int16_t)
+DefineBatchKernel(L2, AVX, std::int16_t)
+DefineBatchKernel(L2, AVX512, std::int16_t)
+
+DefineBatchKernel(Cosine, SSE, std::int8_t)
+DefineBatchKernel(Cosine, AVX, std::int8_t)
+DefineBatchKernel(Cosine, AVX512, std::int8_t)
+DefineBatchKernel(Cosine, SSE, std::uint8_t)
+DefineBatchKernel(Cosine, AVX, std::uint8_t)
+DefineBatchKernel(Cosine, AVX512, std::uint8_t)
+DefineBatchKernel(Cosine, SSE, std::int16_t)
+DefineBatchKernel(Cosine, AVX, std::int16_t)
+DefineBatchKernel(Cosine, AVX512, std::int16_t)
+
+DefineBatchKernel(L2, SSE, Float16)
+DefineBatchKernel(L2, AVX, Float16)
+DefineBatchKernel(L2, AVX512, Float16)
+DefineBatchKernel(L2, SSE, BFloat16)
+DefineBatchKernel(L2, AVX, BFloat16)
+DefineBatchKernel(L2, AVX512, BFloat16)
+DefineBatchKernel(Cosine, SSE, Float16)
+DefineBatchKernel(Cosine, AVX, Float16)
+DefineBatchKernel(Cosine, AVX512, Float16)
+DefineBatchKernel(Cosine, SSE, BFloat16)
+DefineBatchKernel(Cosine, AVX, BFloat16)
+DefineBatchKernel(Cosine, AVX512, BFloat16)
+
+DefineBatchKernel(InnerProduct, SSE, std::int8_t)
+DefineBatchKernel(InnerProduct, AVX, std::int8_t)
+DefineBatchKernel(InnerProduct, AVX512, std::int8_t)
+DefineBatchKernel(InnerProduct, SSE, std::uint8_t)
+DefineBatchKernel(InnerProduct, AVX, std::uint8_t)
+DefineBatchKernel(InnerProduct, AVX512, std::uint8_t)
+DefineBatchKernel(InnerProduct, SSE, std::int16_t)
+DefineBatchKernel(InnerProduct, AVX, std::int16_t)
+DefineBatchKernel(InnerProduct, AVX512, std::int16_t)
+DefineBatchKernel(InnerProduct, SSE, Float16)
+DefineBatchKernel(InnerProduct, AVX, Float16)
+DefineBatchKernel(InnerProduct, AVX512, Float16)
+DefineBatchKernel(InnerProduct, SSE, BFloat16)
+DefineBatchKernel(InnerProduct, AVX, BFloat16)
+DefineBatchKernel(InnerProduct, AVX512, BFloat16)
+
+void DistanceUtils::ComputeL2DistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_SSE<L2Op>, DistanceUtils::ComputeL2Distance_SSE>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeL2DistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX<L2Op>, DistanceUtils::ComputeL2Distance_AVX>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeL2DistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX512<L2Op>, DistanceUtils::ComputeL2Distance_AVX512>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeCosineDistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_SSE<CosineOp>, DistanceUtils::ComputeCosineDistance_SSE>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeCosineDistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX<CosineOp>, DistanceUtils::ComputeCosineDistance_AVX>(pX, pY, count, length, pDist);
 }
+
+void DistanceUtils::ComputeCosineDistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX512<CosineOp>, DistanceUtils::ComputeCosineDistance_AVX512>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeInnerProductDistanceBatch_SSE(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_SSE<InnerProductOp>, DistanceUtils::ComputeInnerProductDistance_SSE>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeInnerProductDistanceBatch_AVX(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX<InnerProductOp>, DistanceUtils::ComputeInnerProductDistance_AVX>(pX, pY, count, length, pDist);
+}
+
+void DistanceUtils::ComputeInnerProductDistanceBatch_AVX512(const float* pX, const float* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeFloatBatch<ComputeBatch4_AVX512<InnerProductOp>, DistanceUtils::ComputeInnerProductDistance_AVX512>(pX, pY, count, length, pDist);
+}
+
+// Lane kernels for the fixed dimension paths. Byte types accumulate madd results in int32, which is
+// exact for every supported dimension, and only convert once at the end; int16 and float accumulate
+// in float like the generic kernels.
+template <typename T> struct Fixed256;
+template <typename T> struct Fixed512;
+
+inline float _mm256_hsum_ps(__m256 X)
+{
+    return _mm_hsum_ps(_mm_add_ps(_mm256_castps256_ps128(X), _mm256_extractf128_ps(X, 1)));
+}
+
+inline int _mm256_hsum_epi32(__m256i X)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(X), _mm256_extracti128_si256(X, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+template <> struct Fixed256<std::int8_t>
+{
+    static const int Width = 32;
+    typedef __m256i Acc;
+    static inline __m256i load(const std::int8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static inline Acc zero() { return _mm256_setzero_si256(); }
+    static inline Acc add(Acc a, Acc b) { return _mm256_add_epi32(a, b); }
+    static inline float reduce(Acc a) { return (float)_mm256_hsum_epi32(a); }
+    static inline Acc l2(__m256i X, __m256i Y)
+    {
+        __m256i dlo = _mm256_sub_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(X)), _mm256_cvtepi8_epi16(_mm256_castsi256_si128(Y)));
+        __m256i dhi = _mm256_sub_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(X, 1)), _mm256_cvtepi8_epi16(_mm256_extracti128_si256(Y, 1)));
+        return _mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi));
+    }
+    static inline Acc dot(__m256i X, __m256i Y)
+    {
+        return _mm256_add_epi32(_mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(X)), _mm256_cvtepi8_epi16(_mm256_castsi256_si128(Y))),
+            _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(X, 1)), _mm256_cvtepi8_epi16(_mm256_extracti128_si256(Y, 1))));
+    }
+};
+
+template <> struct Fixed256<std::uint8_t>
+{
+    static const int Width = 32;
+    typedef __m256i Acc;
+    static inline __m256i load(const std::uint8_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static inline Acc zero() { return _mm256_setzero_si256(); }
+    static inline Acc add(Acc a, Acc b) { return _mm256_add_epi32(a, b); }
+    static inline float reduce(Acc a) { return (float)_mm256_hsum_epi32(a); }
+    static inline Acc l2(__m256i X, __m256i Y)
+    {
+        __m256i dlo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(X)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(Y)));
+        __m256i dhi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(X, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(Y, 1)));
+        return _mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi));
+    }
+    static inline Acc dot(__m256i X, __m256i Y)
+    {
+        return _mm256_add_epi32(_mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(X)), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(Y))),
+            _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(X, 1)), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(Y, 1))));
+    }
+};
+
+template <> struct Fixed256<std::int16_t>
+{
+    static const int Width = 16;
+    typedef __m256 Acc;
+    static inline __m256i load(const std::int16_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static inline Acc zero() { return _mm256_setzero_ps(); }
+    static inline Acc add(Acc a, Acc b) { return _mm256_add_ps(a, b); }
+    static inline float reduce(Acc a) { return _mm256_hsum_ps(a); }
+    static inline Acc l2(__m256i X, __m256i Y)
+    {
+        __m256 dlo = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(X)), _mm256_cvtepi16_epi32(_mm256_castsi256_si128(Y))));
+        __m256 dhi = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(X, 1)), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(Y, 1))));
+        return _mm256_add_ps(_mm256_mul_ps(dlo, dlo), _mm256_mul_ps(dhi, dhi));
+    }
+    static inline Acc dot(__m256i X, __m256i Y) { return _mm256_mul_epi16(X, Y); }
+};
+
+template <> struct Fixed256<float>
+{
+    static const int Width = 8;
+    typedef __m256 Acc;
+    static inline __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+    static inline Acc zero() { return _mm256_setzero_ps(); }
+    static inline Acc add(Acc a, Acc b) { return _mm256_add_ps(a, b); }
+    static inline float reduce(Acc a) { return _mm256_hsum_ps(a); }
+    static inline Acc l2(__m256 X, __m256 Y) { return _mm256_sqdf_ps(X, Y); }
+    static inline Acc dot(__m256 X, __m256 Y) { return _mm256_mul_ps(X, Y); }
+};
+
+// Half precision lanes widen to float on load: vcvtph2ps for Float16, a 16 bit shift for BFloat16.
+template <> struct Fixed256<Float16> : Fixed256<float>
+{
+    static inline __m256 widen(__m128i X) { return _mm256_cvtph_ps(X); }
+    static inline __m256 load(const Float16* p) { return widen(_mm_loadu_si128((const __m128i*)p)); }
+};
+
+template <> struct Fixed256<BFloat16> : Fixed256<float>
+{
+    static inline __m256 widen(__m128i X) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(X), 16)); }
+    static inline __m256 load(const BFloat16* p) { return widen(_mm_loadu_si128((const __m128i*)p)); }
+};
+
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+template <> struct Fixed512<std::int8_t>
+{
+    static const int Width = 64;
+    typedef __m512i Acc;
+    static inline __m512i load(const std::int8_t* p) { return _mm512_loadu_si512((const __m512i*)p); }
+    static inline Acc zero() { return _mm512_setzero_si512(); }
+    static inline Acc add(Acc a, Acc b) { return _mm512_add_epi32(a, b); }
+    static inline float reduce(Acc a) { return (float)_mm512_reduce_add_epi32(a); }
+    static inline Acc l2(__m512i X, __m512i Y)
+    {
+        __m512i dlo = _mm512_sub_epi16(_mm512_cvtepi8_epi16(_mm512_castsi512_si256(X)), _mm512_cvtepi8_epi16(_mm512_castsi512_si256(Y)));
+        __m512i dhi = _mm512_sub_epi16(_mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(X, 1)), _mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(Y, 1)));
+        return _mm512_add_epi32(_mm512_madd_epi16(dlo, dlo), _mm512_madd_epi16(dhi, dhi));
+    }
+    static inline Acc dot(__m512i X, __m512i Y)
+    {
+        return _mm512_add_epi32(_mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm512_castsi512_si256(X)), _mm512_cvtepi8_epi16(_mm512_castsi512_si256(Y))),
+            _mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(X, 1)), _mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(Y, 1))));
+    }
+};
+
+template <> struct Fixed512<std::uint8_t>
+{
+    static const int Width = 64;
+    typedef __m512i Acc;
+    static inline __m512i load(const std::uint8_t* p) { return _mm512_loadu_si512((const __m512i*)p); }
+    static inline Acc zero() { return _mm512_setzero_si512(); }
+    static inline Acc add(Acc a, Acc b) { return _mm512_add_epi32(a, b); }
+    static inline float reduce(Acc a) { return (float)_mm512_reduce_add_epi32(a); }
+    static inline Acc l2(__m512i X, __m512i Y)
+    {
+        __m512i dlo = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(X)), _mm512_cvtepu8_epi16(_mm512_castsi512_si256(Y)));
+        __m512i dhi = _mm512_sub_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(X, 1)), _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(Y, 1)));
+        return _mm512_add_epi32(_mm512_madd_epi16(dlo, dlo), _mm512_madd_epi16(dhi, dhi));
+    }
+    static inline Acc dot(__m512i X, __m512i Y)
+    {
+        return _mm512_add_epi32(_mm512_madd_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(X)), _mm512_cvtepu8_epi16(_mm512_castsi512_si256(Y))),
+            _mm512_madd_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(X, 1)), _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(Y, 1))));
+    }
+};
+
+template <> struct Fixed512<std::int16_t>
+{
+    static const int Width = 32;
+    typedef __m512 Acc;
+    static inline __m512i load(const std::int16_t* p) { return _mm512_loadu_si512((const __m512i*)p); }
+    static inline Acc zero() { return _mm512_setzero_ps(); }
+    static inline Acc add(Acc a, Acc b) { return _mm512_add_ps(a, b); }
+    static inline float reduce(Acc a) { return _mm512_reduce_add_ps(a); }
+    static inline Acc l2(__m512i X, __m512i Y)
+    {
+        __m512 dlo = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_cvtepi16_epi32(_mm512_castsi512_si256(X)), _mm512_cvtepi16_epi32(_mm512_castsi512_si256(Y))));
+        __m512 dhi = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(X, 1)), _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(Y, 1))));
+        return _mm512_add_ps(_mm512_mul_ps(dlo, dlo), _mm512_mul_ps(dhi, dhi));
+    }
+    static inline Acc dot(__m512i X, __m512i Y) { return _mm512_cvtepi32_ps(_mm512_madd_epi16(X, Y)); }
+};
+
+template <> struct Fixed512<float>
+{
+    static const int Width = 16;
+    typedef __m512 Acc;
+    static inline __m512 load(const float* p) { return _mm512_loadu_ps(p); }
+    static inline Acc zero() { return _mm512_setzero_ps(); }
+    static inline Acc add(Acc a, Acc b) { return _mm512_add_ps(a, b); }
+    static inline float reduce(Acc a) { return _mm512_reduce_add_ps(a); }
+    static inline Acc l2(__m512 X, __m512 Y) { return _mm512_sqdf_ps(X, Y); }
+    static inline Acc dot(__m512 X, __m512 Y) { return _mm512_mul_ps(X, Y); }
+};
+
+template <> struct Fixed512<Float16> : Fixed512<float>
+{
+    static inline __m512 widen(__m256i X) { return _mm512_cvtph_ps(X); }
+    static inline __m512 load(const Float16* p) { return widen(_mm256_loadu_si256((const __m256i*)p)); }
+};
+
+template <> struct Fixed512<BFloat16> : Fixed512<float>
+{
+    static inline __m512 widen(__m256i X) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(X), 16)); }
+    static inline __m512 load(const BFloat16* p) { return widen(_mm256_loadu_si256((const __m256i*)p)); }
+};
+#endif
+
+// Generic half precision kernels. Products and sums are taken in float, so the results only differ
+// from the float kernels by the rounding of the inputs. They return the raw sum of squares or products.
+template <typename T, bool IsL2>
+inline float ComputeHalfSum_AVX(const T* pX, const T* pY, DimensionType length)
+{
+    typedef Fixed256<T> K;
+    __m256 acc0 = K::zero(), acc1 = K::zero();
+    DimensionType i = 0;
+    for (; i + 2 * K::Width <= length; i += 2 * K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+        acc1 = K::add(acc1, IsL2 ? K::l2(K::load(pX + i + K::Width), K::load(pY + i + K::Width)) : K::dot(K::load(pX + i + K::Width), K::load(pY + i + K::Width)));
+    }
+    for (; i + K::Width <= length; i += K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+    }
+    float diff = K::reduce(K::add(acc0, acc1));
+    for (; i < length; i++)
+    {
+        float x = pX[i], y = pY[i];
+        diff += IsL2 ? (x - y) * (x - y) : x * y;
+    }
+    return diff;
+}
+
+template <typename T, bool IsL2>
+inline float ComputeHalfSum_AVX512(const T* pX, const T* pY, DimensionType length)
+{
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+    typedef Fixed512<T> K;
+    __m512 acc0 = K::zero(), acc1 = K::zero();
+    DimensionType i = 0;
+    for (; i + 2 * K::Width <= length; i += 2 * K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+        acc1 = K::add(acc1, IsL2 ? K::l2(K::load(pX + i + K::Width), K::load(pY + i + K::Width)) : K::dot(K::load(pX + i + K::Width), K::load(pY + i + K::Width)));
+    }
+    // At most one full block and one partial block remain. Masked lanes load as +0.
+    for (; i < length; i += K::Width)
+    {
+        __mmask32 mask = (length - i >= K::Width) ? (__mmask32)0xFFFF : (__mmask32)((1U << (length - i)) - 1);
+        __m512 X = K::widen(_mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, pX + i)));
+        __m512 Y = K::widen(_mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, pY + i)));
+        acc0 = K::add(acc0, IsL2 ? K::l2(X, Y) : K::dot(X, Y));
+    }
+    return K::reduce(K::add(acc0, acc1));
+#else
+    return ComputeHalfSum_AVX<T, IsL2>(pX, pY, length);
+#endif
+}
+
+// vdpbf16ps multiplies BFloat16 pairs and accumulates in float, which saves the widening shifts on
+// the dot product. Squared distances keep the widened path: x.x + y.y - 2x.y would cancel badly.
+#if !defined _MSC_VER && defined __AVX512BF16__
+#define AVX512BF16_SUPPORTED
+#endif
+
+inline bool BF16Available512()
+{
+#ifdef AVX512BF16_SUPPORTED
+    static const bool available = InstructionSet::AVX512BF16();
+    return available;
+#else
+    return false;
+#endif
+}
+
+// The generic vdpbf16ps kernel beats the widened fixed dimension kernels, so the fixed selector steps aside for it.
+template <typename T>
+inline bool HasNativeDot() { return false; }
+
+template <>
+inline bool HasNativeDot<BFloat16>() { return BF16Available512(); }
+
+#ifdef AVX512BF16_SUPPORTED
+inline float ComputeDotProductBF16_AVX512(const BFloat16* pX, const BFloat16* pY, DimensionType length)
+{
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    DimensionType i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        acc0 = _mm512_dpbf16_ps(acc0, (__m512bh)_mm512_loadu_si512((const __m512i*)(pX + i)), (__m512bh)_mm512_loadu_si512((const __m512i*)(pY + i)));
+        acc1 = _mm512_dpbf16_ps(acc1, (__m512bh)_mm512_loadu_si512((const __m512i*)(pX + i + 32)), (__m512bh)_mm512_loadu_si512((const __m512i*)(pY + i + 32)));
+    }
+    for (; i < length; i += 32)
+    {
+        __mmask32 mask = (length - i >= 32) ? (__mmask32)0xFFFFFFFF : (__mmask32)((1U << (length - i)) - 1);
+        acc0 = _mm512_dpbf16_ps(acc0, (__m512bh)_mm512_maskz_loadu_epi16(mask, pX + i), (__m512bh)_mm512_maskz_loadu_epi16(mask, pY + i));
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+#endif
+
+template <typename T>
+inline float ComputeHalfDotProduct_AVX512(const T* pX, const T* pY, DimensionType length)
+{
+    return ComputeHalfSum_AVX512<T, false>(pX, pY, length);
+}
+
+template <>
+inline float ComputeHalfDotProduct_AVX512<BFloat16>(const BFloat16* pX, const BFloat16* pY, DimensionType length)
+{
+#ifdef AVX512BF16_SUPPORTED
+    if (BF16Available512()) return ComputeDotProductBF16_AVX512(pX, pY, length);
+#endif
+    return ComputeHalfSum_AVX512<BFloat16, false>(pX, pY, length);
+}
+
+#define DefineHalfKernels(Type) \
+float DistanceUtils::ComputeL2Distance_SSE(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeL2Distance(pX, pY, length); \
+} \
+float DistanceUtils::ComputeL2Distance_AVX(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeHalfSum_AVX<Type, true>(pX, pY, length); \
+} \
+float DistanceUtils::ComputeL2Distance_AVX512(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeHalfSum_AVX512<Type, true>(pX, pY, length); \
+} \
+float DistanceUtils::ComputeCosineDistance_SSE(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeCosineDistance(pX, pY, length); \
+} \
+float DistanceUtils::ComputeCosineDistance_AVX(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return 1 - ComputeHalfSum_AVX<Type, false>(pX, pY, length); \
+} \
+float DistanceUtils::ComputeCosineDistance_AVX512(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return 1 - ComputeHalfDotProduct_AVX512(pX, pY, length); \
+} \
+float DistanceUtils::ComputeInnerProductDistance_SSE(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeInnerProductDistance(pX, pY, length); \
+} \
+float DistanceUtils::ComputeInnerProductDistance_AVX(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return -ComputeHalfSum_AVX<Type, false>(pX, pY, length); \
+} \
+float DistanceUtils::ComputeInnerProductDistance_AVX512(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return -ComputeHalfDotProduct_AVX512(pX, pY, length); \
+} \
+
+DefineHalfKernels(Float16)
+DefineHalfKernels(BFloat16)
+#undef DefineHalfKernels
+
+// All supported dimensions are multiples of 32 elements, so the loops below have compile time
+// trip counts and no scalar tail.
+template <typename T, int D, bool IsL2>
+float ComputeDistanceFixed_AVX(const T* pX, const T* pY, DimensionType)
+{
+    typedef Fixed256<T> K;
+    typename K::Acc acc0 = K::zero(), acc1 = K::zero();
+    int i = 0;
+    for (; i + 2 * K::Width <= D; i += 2 * K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+        acc1 = K::add(acc1, IsL2 ? K::l2(K::load(pX + i + K::Width), K::load(pY + i + K::Width)) : K::dot(K::load(pX + i + K::Width), K::load(pY + i + K::Width)));
+    }
+    for (; i < D; i += K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+    }
+    float diff = K::reduce(K::add(acc0, acc1));
+    return IsL2 ? diff : Utils::GetBase<T>() * Utils::GetBase<T>() - diff;
+}
+
+template <typename T, int D, bool IsL2>
+float ComputeDistanceFixed_AVX512(const T* pX, const T* pY, DimensionType length)
+{
+#if (!defined _MSC_VER) || (_MSC_VER >= 1920)
+    typedef Fixed512<T> K;
+    typedef Fixed256<T> H;
+    typename K::Acc acc0 = K::zero(), acc1 = K::zero();
+    int i = 0;
+    for (; i + 2 * K::Width <= D; i += 2 * K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+        acc1 = K::add(acc1, IsL2 ? K::l2(K::load(pX + i + K::Width), K::load(pY + i + K::Width)) : K::dot(K::load(pX + i + K::Width), K::load(pY + i + K::Width)));
+    }
+    for (; i + K::Width <= D; i += K::Width)
+    {
+        acc0 = K::add(acc0, IsL2 ? K::l2(K::load(pX + i), K::load(pY + i)) : K::dot(K::load(pX + i), K::load(pY + i)));
+    }
+    float diff = K::reduce(K::add(acc0, acc1));
+    if (i < D)
+    {
+        typename H::Acc tail = H::zero();
+        for (; i < D; i += H::Width)
+        {
+            tail = H::add(tail, IsL2 ? H::l2(H::load(pX + i), H::load(pY + i)) : H::dot(H::load(pX + i), H::load(pY + i)));
+        }
+        diff += H::reduce(tail);
+    }
+    return IsL2 ? diff : Utils::GetBase<T>() * Utils::GetBase<T>() - diff;
+#else
+    return ComputeDistanceFixed_AVX<T, D, IsL2>(pX, pY, length);
+#endif
+}
+
+// vpdpbusd multiplies unsigned bytes by signed bytes. Dot products bias one operand by 128 (x ^ 0x80) and
+// remove the bias with a second vpdpbusd against a vector of ones. Squared distances use d = |x - y|, which
+// always fits an unsigned byte: d * d = d * (d & 0x7F) + 128 * d * (d >> 7).
+#if (!defined _MSC_VER && defined __AVX512VNNI__) || (defined _MSC_VER && _MSC_VER >= 1920)
+#define AVX512VNNI_SUPPORTED
+#endif
+#if (!defined _MSC_VER && defined __AVXVNNI__) || (defined _MSC_VER && _MSC_VER >= 1930)
+#define AVXVNNI_SUPPORTED
+#endif
+
+inline bool VNNIAvailable512()
+{
+#ifdef AVX512VNNI_SUPPORTED
+    return InstructionSet::AVX512VNNI();
+#else
+    return false;
+#endif
+}
+
+inline bool VNNIAvailable256()
+{
+#ifdef AVXVNNI_SUPPORTED
+    return InstructionSet::AVXVNNI();
+#else
+    return false;
+#endif
+}
+
+template <typename T> struct VNNI;
+
+template <> struct VNNI<std::int8_t>
+{
+    // sum((x + 128) * y) - 128 * sum(y)
+    static const int Sign = -1;
+#ifdef AVX512VNNI_SUPPORTED
+    static inline __m512i absdiff(__m512i X, __m512i Y) { return _mm512_sub_epi8(_mm512_max_epi8(X, Y), _mm512_min_epi8(X, Y)); }
+    static inline __m512i dot(__m512i acc, __m512i X, __m512i Y) { return _mm512_dpbusd_epi32(acc, _mm512_xor_si512(X, _mm512_set1_epi8((char)0x80)), Y); }
+    static inline __m512i sum(__m512i acc, __m512i, __m512i Y) { return _mm512_dpbusd_epi32(acc, _mm512_set1_epi8(1), Y); }
+#endif
+#ifdef AVXVNNI_SUPPORTED
+    static inline __m256i absdiff(__m256i X, __m256i Y) { return _mm256_sub_epi8(_mm256_max_epi8(X, Y), _mm256_min_epi8(X, Y)); }
+    static inline __m256i dot(__m256i acc, __m256i X, __m256i Y) { return _mm256_dpbusd_avx_epi32(acc, _mm256_xor_si256(X, _mm256_set1_epi8((char)0x80)), Y); }
+    static inline __m256i sum(__m256i acc, __m256i, __m256i Y) { return _mm256_dpbusd_avx_epi32(acc, _mm256_set1_epi8(1), Y); }
+#endif
+};
+
+template <> struct VNNI<std::uint8_t>
+{
+    // sum(x * (y - 128)) + 128 * sum(x)
+    static const int Sign = 1;
+#ifdef AVX512VNNI_SUPPORTED
+    static inline __m512i absdiff(__m512i X, __m512i Y) { return _mm512_sub_epi8(_mm512_max_epu8(X, Y), _mm512_min_epu8(X, Y)); }
+    static inline __m512i dot(__m512i acc, __m512i X, __m512i Y) { return _mm512_dpbusd_epi32(acc, X, _mm512_xor_si512(Y, _mm512_set1_epi8((char)0x80))); }
+    static inline __m512i sum(__m512i acc, __m512i X, __m512i) { return _mm512_dpbusd_epi32(acc, X, _mm512_set1_epi8(1)); }
+#endif
+#ifdef AVXVNNI_SUPPORTED
+    static inline __m256i absdiff(__m256i X, __m256i Y) { return _mm256_sub_epi8(_mm256_max_epu8(X, Y), _mm256_min_epu8(X, Y)); }
+    static inline __m256i dot(__m256i acc, __m256i X, __m256i Y) { return _mm256_dpbusd_avx_epi32(acc, X, _mm256_xor_si256(Y, _mm256_set1_epi8((char)0x80))); }
+    static inline __m256i sum(__m256i acc, __m256i X, __m256i) { return _mm256_dpbusd_avx_epi32(acc, X, _mm256_set1_epi8(1)); }
+#endif
+};
+
+#ifdef AVX512VNNI_SUPPORTED
+template <typename T, bool IsL2>
+inline void AccumulateVNNI512(__m512i X, __m512i Y, __m512i& acc0, __m512i& acc1)
+{
+    if (IsL2)
+    {
+        __m512i d = VNNI<T>::absdiff(X, Y);
+        acc0 = _mm512_dpbusd_epi32(acc0, d, _mm512_and_si512(d, _mm512_set1_epi8(0x7F)));
+        acc1 = _mm512_dpbusd_epi32(acc1, d, _mm512_and_si512(_mm512_srli_epi16(d, 7), _mm512_set1_epi8(0x01)));
+    }
+    else
+    {
+        acc0 = VNNI<T>::dot(acc0, X, Y);
+        acc1 = VNNI<T>::sum(acc1, X, Y);
+    }
+}
+
+template <typename T, bool IsL2>
+inline float ComputeDistanceVNNI512(const T* pX, const T* pY, DimensionType length)
+{
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    DimensionType i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        AccumulateVNNI512<T, IsL2>(_mm512_loadu_si512((const __m512i*)(pX + i)), _mm512_loadu_si512((const __m512i*)(pY + i)), acc0, acc1);
+    }
+    if (i < length)
+    {
+        // Masked loads zero the lanes past the end, which contribute nothing to either sum.
+        __mmask64 mask = (__mmask64)((1ULL << (length - i)) - 1);
+        AccumulateVNNI512<T, IsL2>(_mm512_maskz_loadu_epi8(mask, pX + i), _mm512_maskz_loadu_epi8(mask, pY + i), acc0, acc1);
+    }
+    std::int64_t lo = _mm512_reduce_add_epi32(acc0), hi = _mm512_reduce_add_epi32(acc1);
+    if (IsL2) return (float)(lo + (hi << 7));
+    return Utils::GetBase<T>() * Utils::GetBase<T>() - (float)(lo + VNNI<T>::Sign * (hi << 7));
+}
+#endif
+
+#ifdef AVXVNNI_SUPPORTED
+template <typename T, bool IsL2>
+inline float ComputeDistanceVNNI256(const T* pX, const T* pY, DimensionType length)
+{
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    DimensionType i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i X = _mm256_loadu_si256((const __m256i*)(pX + i)), Y = _mm256_loadu_si256((const __m256i*)(pY + i));
+        if (IsL2)
+        {
+            __m256i d = VNNI<T>::absdiff(X, Y);
+            acc0 = _mm256_dpbusd_avx_epi32(acc0, d, _mm256_and_si256(d, _mm256_set1_epi8(0x7F)));
+            acc1 = _mm256_dpbusd_avx_epi32(acc1, d, _mm256_and_si256(_mm256_srli_epi16(d, 7), _mm256_set1_epi8(0x01)));
+        }
+        else
+        {
+            acc0 = VNNI<T>::dot(acc0, X, Y);
+            acc1 = VNNI<T>::sum(acc1, X, Y);
+        }
+    }
+    std::int64_t lo = _mm256_hsum_epi32(acc0), hi = _mm256_hsum_epi32(acc1);
+    std::int64_t diff = IsL2 ? lo + (hi << 7) : lo + VNNI<T>::Sign * (hi << 7);
+    for (; i < length; i++)
+    {
+        int x = pX[i], y = pY[i];
+        diff += IsL2 ? (x - y) * (x - y) : x * y;
+    }
+    if (IsL2) return (float)diff;
+    return Utils::GetBase<T>() * Utils::GetBase<T>() - (float)diff;
+}
+#endif
+
+#ifdef AVX512VNNI_SUPPORTED
+#define DefineVNNIKernel512(Method, IsL2, Type) \
+float DistanceUtils::Compute##Method##Distance_AVX512VNNI(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeDistanceVNNI512<Type, IsL2>(pX, pY, length); \
+} \
+
+#else
+#define DefineVNNIKernel512(Method, IsL2, Type) \
+float DistanceUtils::Compute##Method##Distance_AVX512VNNI(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return Compute##Method##Distance_AVX512(pX, pY, length); \
+} \
+
+#endif
+
+#ifdef AVXVNNI_SUPPORTED
+#define DefineVNNIKernel256(Method, IsL2, Type) \
+float DistanceUtils::Compute##Method##Distance_AVXVNNI(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return ComputeDistanceVNNI256<Type, IsL2>(pX, pY, length); \
+} \
+
+#else
+#define DefineVNNIKernel256(Method, IsL2, Type) \
+float DistanceUtils::Compute##Method##Distance_AVXVNNI(const Type* pX, const Type* pY, DimensionType length) \
+{ \
+    return Compute##Method##Distance_AVX(pX, pY, length); \
+} \
+
+#endif
+
+DefineVNNIKernel512(L2, true, std::int8_t)
+DefineVNNIKernel512(L2, true, std::uint8_t)
+DefineVNNIKernel512(Cosine, false, std::int8_t)
+DefineVNNIKernel512(Cosine, false, std::uint8_t)
+DefineVNNIKernel256(L2, true, std::int8_t)
+DefineVNNIKernel256(L2, true, std::uint8_t)
+DefineVNNIKernel256(Cosine, false, std::int8_t)
+DefineVNNIKernel256(Cosine, false, std::uint8_t)
+#undef DefineVNNIKernel512
+#undef DefineVNNIKernel256
+
+DefineBatchKernel(L2, AVX512VNNI, std::int8_t)
+DefineBatchKernel(L2, AVX512VNNI, std::uint8_t)
+DefineBatchKernel(Cosine, AVX512VNNI, std::int8_t)
+DefineBatchKernel(Cosine, AVX512VNNI, std::uint8_t)
+DefineBatchKernel(L2, AVXVNNI, std::int8_t)
+DefineBatchKernel(L2, AVXVNNI, std::uint8_t)
+DefineBatchKernel(Cosine, AVXVNNI, std::int8_t)
+DefineBatchKernel(Cosine, AVXVNNI, std::uint8_t)
+#undef DefineBatchKernel
+
+template <typename T>
+struct VNNIKernels
+{
+    static const bool Available = false;
+    static DistanceCalcReturn<T> Select(bool) { return nullptr; }
+    static DistanceBatchCalcReturn<T> SelectBatch(bool) { return nullptr; }
+};
+
+#define DefineVNNIKernels(Type) \
+template <> \
+struct VNNIKernels<Type> \
+{ \
+    static const bool Available = true; \
+    static DistanceCalcReturn<Type> Select(bool isL2) \
+    { \
+        if (VNNIAvailable512()) \
+        { \
+            if (isL2) return &(DistanceUtils::ComputeL2Distance_AVX512VNNI); \
+            return &(DistanceUtils::ComputeCosineDistance_AVX512VNNI); \
+        } \
+        if (VNNIAvailable256()) \
+        { \
+            if (isL2) return &(DistanceUtils::ComputeL2Distance_AVXVNNI); \
+            return &(DistanceUtils::ComputeCosineDistance_AVXVNNI); \
+        } \
+        return nullptr; \
+    } \
+    static DistanceBatchCalcReturn<Type> SelectBatch(bool isL2) \
+    { \
+        if (VNNIAvailable512()) \
+        { \
+            if (isL2) return &(DistanceUtils::ComputeL2DistanceBatch_AVX512VNNI); \
+            return &(DistanceUtils::ComputeCosineDistanceBatch_AVX512VNNI); \
+        } \
+        if (VNNIAvailable256()) \
+        { \
+            if (isL2) return &(DistanceUtils::ComputeL2DistanceBatch_AVXVNNI); \
+            return &(DistanceUtils::ComputeCosineDistanceBatch_AVXVNNI); \
+        } \
+        return nullptr; \
+    } \
+}; \
+
+DefineVNNIKernels(std::int8_t)
+DefineVNNIKernels(std::uint8_t)
+#undef DefineVNNIKernels
+
+// Fixed dimension VNNI kernels: the generic VNNI loops instantiated with a compile time length.
+template <typename T, int D, bool IsL2>
+float ComputeDistanceFixed_AVX512VNNI(const T* pX, const T* pY, DimensionType length)
+{
+#ifdef AVX512VNNI_SUPPORTED
+    return ComputeDistanceVNNI512<T, IsL2>(pX, pY, D);
+#else
+    return ComputeDistanceFixed_AVX512<T, D, IsL2>(pX, pY, length);
+#endif
+}
+
+template <typename T, int D, bool IsL2>
+float ComputeDistanceFixed_AVXVNNI(const T* pX, const T* pY, DimensionType length)
+{
+#ifdef AVXVNNI_SUPPORTED
+    return ComputeDistanceVNNI256<T, IsL2>(pX, pY, D);
+#else
+    return ComputeDistanceFixed_AVX<T, D, IsL2>(pX, pY, length);
+#endif
+}
+
+template <typename T, int D, bool IsL2>
+void ComputeDistanceBatchFixed_AVX512VNNI(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeBatch<T, ComputeDistanceFixed_AVX512VNNI<T, D, IsL2>>(pX, pY, count, length, pDist);
+}
+
+template <typename T, int D, bool IsL2>
+void ComputeDistanceBatchFixed_AVXVNNI(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeBatch<T, ComputeDistanceFixed_AVXVNNI<T, D, IsL2>>(pX, pY, count, length, pDist);
+}
+
+template <typename T, int D, bool IsL2>
+void ComputeDistanceBatchFixed_AVX(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeBatch<T, ComputeDistanceFixed_AVX<T, D, IsL2>>(pX, pY, count, length, pDist);
+}
+
+template <typename T, int D, bool IsL2>
+void ComputeDistanceBatchFixed_AVX512(const T* pX, const T* const* pY, int count, DimensionType length, float* pDist)
+{
+    ComputeBatch<T, ComputeDistanceFixed_AVX512<T, D, IsL2>>(pX, pY, count, length, pDist);
+}
+
+#define FixedDimensionCases(Case, Kernel) \
+        Case(Kernel, 64) \
+        Case(Kernel, 96) \
+        Case(Kernel, 128) \
+        Case(Kernel, 256) \
+        Case(Kernel, 768) \
+
+#define FixedDimensionCase(Kernel, D) \
+            case D: \
+                if (InstructionSet::AVX512()) return &(Kernel##_AVX512<T, D, IsL2>); \
+                return &(Kernel##_AVX<T, D, IsL2>); \
+
+#define FixedDimensionVNNICase(Kernel, D) \
+            case D: \
+                if (VNNIAvailable512()) return &(Kernel##_AVX512VNNI<T, D, IsL2>); \
+                if (VNNIAvailable256()) return &(Kernel##_AVXVNNI<T, D, IsL2>); \
+                break; \
+
+// Only int8/uint8 have VNNI kernels; the primary template keeps the other types from instantiating them.
+template <typename T, bool IsL2, bool HasVNNI = VNNIKernels<T>::Available>
+struct FixedVNNIKernels
+{
+    static DistanceCalcReturn<T> Select(DimensionType) { return nullptr; }
+    static DistanceBatchCalcReturn<T> SelectBatch(DimensionType) { return nullptr; }
+};
+
+template <typename T, bool IsL2>
+struct FixedVNNIKernels<T, IsL2, true>
+{
+    static DistanceCalcReturn<T> Select(DimensionType p_dimension)
+    {
+        switch (p_dimension)
+        {
+            FixedDimensionCases(FixedDimensionVNNICase, ComputeDistanceFixed)
+        default:
+            break;
+        }
+        return nullptr;
+    }
+
+    static DistanceBatchCalcReturn<T> SelectBatch(DimensionType p_dimension)
+    {
+        switch (p_dimension)
+        {
+            FixedDimensionCases(FixedDimensionVNNICase, ComputeDistanceBatchFixed)
+        default:
+            break;
+        }
+        return nullptr;
+    }
+};
+
+template <typename T, bool IsL2>
+static DistanceCalcReturn<T> SelectFixedDistance(DimensionType p_dimension)
+{
+    DistanceCalcReturn<T> func = FixedVNNIKernels<T, IsL2>::Select(p_dimension);
+    if (func != nullptr) return func;
+
+    if (!InstructionSet::AVX2()) return nullptr;
+    switch (p_dimension)
+    {
+        FixedDimensionCases(FixedDimensionCase, ComputeDistanceFixed)
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename T, bool IsL2>
+static DistanceBatchCalcReturn<T> SelectFixedBatchDistance(DimensionType p_dimension)
+{
+    DistanceBatchCalcReturn<T> func = FixedVNNIKernels<T, IsL2>::SelectBatch(p_dimension);
+    if (func != nullptr) return func;
+
+    if (!InstructionSet::AVX2()) return nullptr;
+    switch (p_dimension)
+    {
+        FixedDimensionCases(FixedDimensionCase, ComputeDistanceBatchFixed)
+    default:
+        break;
+    }
+    return nullptr;
+}
+#undef FixedDimensionVNNICase
+#undef FixedDimensionCase
+#undef FixedDimensionCases
+
+template <typename T>
+DistanceCalcReturn<T> DistanceUtils::FixedDimensionCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)
+{
+    switch (p_method)
+    {
+    case SPTAG::DistCalcMethod::Cosine:
+        if (HasNativeDot<T>()) return nullptr;
+        return SelectFixedDistance<T, false>(p_dimension);
+    case SPTAG::DistCalcMethod::L2:
+        return SelectFixedDistance<T, true>(p_dimension);
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename T>
+DistanceBatchCalcReturn<T> DistanceUtils::FixedDimensionBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)
+{
+    switch (p_method)
+    {
+    case SPTAG::DistCalcMethod::Cosine:
+        if (HasNativeDot<T>()) return nullptr;
+        return SelectFixedBatchDistance<T, false>(p_dimension);
+    case SPTAG::DistCalcMethod::L2:
+        return SelectFixedBatchDistance<T, true>(p_dimension);
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename T>
+DistanceCalcReturn<T> DistanceUtils::VNNICalcSelector(SPTAG::DistCalcMethod p_method)
+{
+    switch (p_method)
+    {
+    case SPTAG::DistCalcMethod::Cosine:
+        return VNNIKernels<T>::Select(false);
+    case SPTAG::DistCalcMethod::L2:
+        return VNNIKernels<T>::Select(true);
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename T>
+DistanceBatchCalcReturn<T> DistanceUtils::VNNIBatchCalcSelector(SPTAG::DistCalcMethod p_method)
+{
+    switch (p_method)
+    {
+    case SPTAG::DistCalcMethod::Cosine:
+        return VNNIKernels<T>::SelectBatch(false);
+    case SPTAG::DistCalcMethod::L2:
+        return VNNIKernels<T>::SelectBatch(true);
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+#define DefineVectorValueType(Name, Type) \
+template DistanceCalcReturn<Type> DistanceUtils::FixedDimensionCalcSelector<Type>(SPTAG::DistCalcMethod, DimensionType); \
+template DistanceBatchCalcReturn<Type> DistanceUtils::FixedDimensionBatchCalcSelector<Type>(SPTAG::DistCalcMethod, DimensionType); \
+template DistanceCalcReturn<Type> DistanceUtils::VNNICalcSelector<Type>(SPTAG::DistCalcMethod); \
+template DistanceBatchCalcReturn<Type> DistanceUtils::VNNIBatchCalcSelector<Type>(SPTAG::DistCalcMethod); \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
@@ -5,6 +5,10 @@
 void cpuid(int info[4], int InfoType) {
     __cpuid_count(InfoType, 0, info[0], info[1], info[2], info[3]);
 }
+
+void cpuidex(int info[4], int InfoType, int SubLeaf) {
+    __cpuid_count(InfoType, SubLeaf, info[0], info[1], info[2], info[3]);
+}
 #endif
 
 namespace SPTAG {
@@ -16,6 +20,9 @@ namespace SPTAG {
         bool InstructionSet::AVX(void) { return CPU_Rep.HW_AVX; }
         bool InstructionSet::AVX2(void) { return CPU_Rep.HW_AVX2; }
         bool InstructionSet::AVX512(void) { return CPU_Rep.HW_AVX512; }
+        bool InstructionSet::AVX512VNNI(void) { return CPU_Rep.HW_AVX512VNNI; }
+        bool InstructionSet::AVXVNNI(void) { return CPU_Rep.HW_AVXVNNI; }
+        bool InstructionSet::AVX512BF16(void) { return CPU_Rep.HW_AVX512BF16; }
         
         void InstructionSet::PrintInstructionSet(void) 
         {
@@ -31,6 +38,14 @@ namespace SPTAG {
                 LOG(Helper::LogLevel::LL_Info, "Using SSE InstructionSet!\n");
             else
                 LOG(Helper::LogLevel::LL_Info, "Using NONE InstructionSet!\n");
+
+            if (CPU_Rep.HW_AVX512VNNI)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX512-VNNI for int8/uint8 distance!\n");
+            else if (CPU_Rep.HW_AVXVNNI)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX-VNNI for int8/uint8 distance!\n");
+
+            if (CPU_Rep.HW_AVX512BF16)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX512-BF16 for BFloat16 distance!\n");
         }
 
         // from https://stackoverflow.com/a/7495023/5053214
@@ -39,7 +54,10 @@ namespace SPTAG {
             HW_SSE2{ false },
             HW_AVX{ false },
             HW_AVX512{ false },
-            HW_AVX2{ false }
+            HW_AVX2{ false },
+            HW_AVX512VNNI{ false },
+            HW_AVXVNNI{ false },
+            HW_AVX512BF16{ false }
         {
             int info[4];
             cpuid(info, 0);
@@ -56,11 +74,23 @@ namespace SPTAG {
                 cpuid(info, 0x00000007);
                 HW_AVX2 = (info[1] & ((int)1 << 5)) != 0;
                 HW_AVX512 = (info[1] & (((int)1 << 16) | ((int) 1 << 30)));
+                HW_AVX512VNNI = HW_AVX512 && (info[2] & ((int)1 << 11)) != 0;
+                int nSubLeafs = info[0];
+                if (nSubLeafs >= 1) {
+                    cpuidex(info, 0x00000007, 1);
+                    HW_AVXVNNI = HW_AVX2 && (info[0] & ((int)1 << 4)) != 0;
+                    HW_AVX512BF16 = HW_AVX512 && (info[0] & ((int)1 << 5)) != 0;
+                }
 
 // If we are not compiling support for AVX-512 due to old compiler version, we should not call it
 #ifdef _MSC_VER
 #if _MSC_VER < 1920
                 HW_AVX512 = false;
+                HW_AVX512VNNI = false;
+                HW_AVX512BF16 = false;
+#endif
+#if _MSC_VER < 1930
+                HW_AVXVNNI = false;
 #endif
 #endif
             }
@@ -76,6 +106,14 @@ namespace SPTAG {
                 LOG(Helper::LogLevel::LL_Info, "Using SSE InstructionSet!\n");
             else
                 LOG(Helper::LogLevel::LL_Info, "Using NONE InstructionSet!\n");
+
+            if (HW_AVX512VNNI)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX512-VNNI for int8/uint8 distance!\n");
+            else if (HW_AVXVNNI)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX-VNNI for int8/uint8 distance!\n");
+
+            if (HW_AVX512BF16)
+                LOG(Helper::LogLevel::LL_Info, "Using AVX512-BF16 for BFloat16 distance!\n");
         }
     }
 }
@@ -234,3 +234,44 @@ void SIMDUtils::ComputeSum_AVX512(float* pX, const float* pY, DimensionType leng
         *pX++ += *pY++;
     }
 }
+
+void SIMDUtils::ComputeSum_SSE(Float16* pX, const Float16* pY, DimensionType length)
+{
+    ComputeSum_Naive(pX, pY, length);
+}
+
+void SIMDUtils::ComputeSum_AVX(Float16* pX, const Float16* pY, DimensionType length)
+{
+    const Float16* pEnd8 = pX + ((length >> 3) << 3);
+    const Float16* pEnd1 = pX + length;
+
+    while (pX < pEnd8) {
+        __m256 x_part = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)pX));
+        __m256 y_part = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)pY));
+        x_part = _mm256_add_ps(x_part, y_part);
+        _mm_storeu_si128((__m128i*)pX, _mm256_cvtps_ph(x_part, _MM_FROUND_TO_NEAREST_INT));
+        pX += 8;
+        pY += 8;
+    }
+
+    while (pX < pEnd1) {
+        *pX++ += *pY++;
+    }
+}
+
+void SIMDUtils::ComputeSum_AVX512(Float16* pX, const Float16* pY, DimensionType length)
+{
+    const Float16* pEnd16 = pX + ((length >> 4) << 4);
+    const Float16* pEnd1 = pX + length;
+
+    while (pX < pEnd16) {
+        __m512 x_part = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)pX));
+        __m512 y_part = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)pY));
+        x_part = _mm512_add_ps(x_part, y_part);
+        _mm256_storeu_si256((__m256i*)pX, _mm512_cvtps_ph(x_part, _MM_FROUND_TO_NEAREST_INT));
+        pX += 16;
+        pY += 16;
+    }
+
+    ComputeSum_AVX(pX, pY, (DimensionType)(pEnd1 - pX));
+}
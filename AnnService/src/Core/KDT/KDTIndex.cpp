@@ -34,11 +34,13 @@ namespace SPTAG
             if (m_pQuantizer)
             {
                 m_fComputeDistance = m_pQuantizer->DistanceCalcSelector<std::uint8_t>(m_iDistCalcMethod);
+                m_fComputeDistanceBatch = nullptr;
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? m_pQuantizer->GetBase() * m_pQuantizer->GetBase() : 1;
             }
             else
             {
                 m_fComputeDistance = COMMON::DistanceCalcSelector<std::uint8_t>(m_iDistCalcMethod);
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<std::uint8_t>(m_iDistCalcMethod);
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<std::uint8_t>() * COMMON::Utils::GetBase<std::uint8_t>() : 1;
             }
         }
@@ -59,15 +61,18 @@ namespace SPTAG
         {
             if (p_indexBlobs.size() < 3) return ErrorCode::LackOfInputs;
 
+            SelectHugePages();
+
             if (m_pSamples.Load((char*)p_indexBlobs[0].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (m_pTrees.LoadTrees((char*)p_indexBlobs[1].Data()) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (m_pGraph.LoadGraph((char*)p_indexBlobs[2].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
             if (p_indexBlobs.size() <= 3) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if (m_deletedID.Load((char*)p_indexBlobs[3].Data(), m_iDataBlockSize, m_iDataCapacity) != ErrorCode::Success) return ErrorCode::FailedParseValue;
 
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
             return ErrorCode::Success;
         }
@@ -77,6 +82,7 @@ namespace SPTAG
         {
             if (p_indexStreams.size() < 4) return ErrorCode::LackOfInputs;
 
+            SelectHugePages();
             ErrorCode ret = ErrorCode::Success;
             if (p_indexStreams[0] == nullptr || (ret = m_pSamples.Load(p_indexStreams[0], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
             if (p_indexStreams[1] == nullptr || (ret = m_pTrees.LoadTrees(p_indexStreams[1])) != ErrorCode::Success) return ret;
@@ -84,9 +90,10 @@ namespace SPTAG
             if (p_indexStreams[3] == nullptr) m_deletedID.Initialize(m_pSamples.R(), m_iDataBlockSize, m_iDataCapacity);
             else if ((ret = m_deletedID.Load(p_indexStreams[3], m_iDataBlockSize, m_iDataCapacity)) != ErrorCode::Success) return ret;
 
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
             return ret;
         }
@@ -129,10 +136,13 @@ namespace SPTAG
 #define Search(CheckDeleted) \
         std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
         m_pTrees.InitSearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space); \
-        m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfInitialDynamicPivots); \
+        m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, initialPivots); \
+        if (policy != nullptr) policy->Start(p_space); \
+        p_space.ReserveBatch(m_pGraph.m_iNeighborhoodSize); \
         while (!p_space.m_NGQueue.empty()) { \
             NodeDistPair gnode = p_space.m_NGQueue.pop(); \
             const SizeType *node = m_pGraph[gnode.node]; \
+            float worstBefore = p_query.worstDist(); \
             _mm_prefetch((const char *)node, _MM_HINT_T0); \
             for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize; i++) \
                 _mm_prefetch((const char *)(m_pSamples)[node[i]], _MM_HINT_T0); \
@@ -143,24 +153,31 @@ namespace SPTAG
             } \
             float upperBound = max(p_query.worstDist(), gnode.distance); \
             bool bLocalOpt = true; \
+            int batchCount = 0; \
             for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize; i++) { \
                 SizeType nn_index = node[i]; \
                 if (nn_index < 0) break; \
                 if (p_space.CheckAndSet(nn_index)) continue; \
-                float distance2leaf = m_fComputeDistance(p_query.GetQuantizedTarget(), (m_pSamples)[nn_index], GetFeatureDim()); \
+                p_space.m_batchIDs[batchCount++] = nn_index; \
+            } \
+            ComputeDistanceBatch(p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data()); \
+            for (int i = 0; i < batchCount; i++) { \
+                float distance2leaf = p_space.m_batchDists[i]; \
                 if (distance2leaf <= upperBound) bLocalOpt = false; \
                 p_space.m_iNumberOfCheckedLeaves++; \
-                p_space.m_NGQueue.insert(NodeDistPair(nn_index, distance2leaf)); \
+                p_space.m_NGQueue.insert(NodeDistPair(p_space.m_batchIDs[i], distance2leaf)); \
             } \
             if (bLocalOpt) p_space.m_iNumOfContinuousNoBetterPropagation++; \
             else p_space.m_iNumOfContinuousNoBetterPropagation = 0; \
-            if (p_space.m_iNumOfContinuousNoBetterPropagation > m_iThresholdOfNumberOfContinuousNoBetterPropagation) { \
+            if (p_space.m_iNumOfContinuousNoBetterPropagation > continuousLimit) { \
                 if (p_space.m_iNumberOfTreeCheckedLeaves <= p_space.m_iNumberOfCheckedLeaves / 10) { \
-                    m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
+                    m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, otherPivots + p_space.m_iNumberOfCheckedLeaves); \
                 } else if (gnode.distance > p_query.worstDist()) { \
                     break; \
                 } \
             } \
+            if (policy != nullptr && policy->Stop(p_space, p_query.worstDist(), p_query.worstDist() < worstBefore)) break; \
+            if (p_space.m_iNumberOfCheckedLeaves > checkBudget) break; \
         } \
         p_query.SortResult(); \
 
@@ -169,7 +186,23 @@ namespace SPTAG
         template <typename Q>
         void Index<T>::SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const
         {
-            if (m_deletedID.Count() == 0 || p_searchDeleted) {
+            const COMMON::ITerminationPolicy* policy = p_query.GetTerminationPolicy().get();
+            const SearchOptions& options = p_query.GetSearchOptions();
+            const int initialPivots = SearchOptions::Pick(options.m_initialDynamicPivots, m_iNumberOfInitialDynamicPivots);
+            const int otherPivots = SearchOptions::Pick(options.m_otherDynamicPivots, m_iNumberOfOtherDynamicPivots);
+            const int continuousLimit = SearchOptions::Pick(options.m_continuousLimit, m_iThresholdOfNumberOfContinuousNoBetterPropagation);
+            const IFilter* filter = p_query.GetFilter().get();
+            const SizeType checkBudget = (filter == nullptr) ? MaxSize : filter->CheckBudget(p_space.m_iMaxCheck, m_pSamples.R());
+            if (filter != nullptr) {
+                SizeType accepted = filter->AcceptedCount();
+                if (accepted >= 0 && accepted <= p_space.m_iMaxCheck) {
+                    SearchIndexByFilter(p_query, p_space, *filter, p_searchDeleted);
+                }
+                else {
+                    Search(if ((p_searchDeleted || !m_deletedID.Contains(gnode.node)) && filter->Accept(gnode.node)))
+                }
+            }
+            else if (m_deletedID.Count() == 0 || p_searchDeleted) {
                 Search(;)
             }
             else {
@@ -177,14 +210,35 @@ namespace SPTAG
             }
         }
 
+        template <typename T>
+        void Index<T>::SearchIndexByFilter(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, const IFilter& p_filter, bool p_searchDeleted) const
+        {
+            const SizeType end = m_pSamples.R();
+            const int batchSize = 64;
+            p_space.ReserveBatch(batchSize);
+
+            SizeType vid = p_filter.NextAccepted(0, end);
+            while (vid < end) {
+                int batchCount = 0;
+                for (; vid < end && batchCount < batchSize; vid = p_filter.NextAccepted(vid + 1, end)) {
+                    if (p_searchDeleted || !m_deletedID.Contains(vid)) p_space.m_batchIDs[batchCount++] = vid;
+                }
+                ComputeDistanceBatch(p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data());
+                for (int i = 0; i < batchCount; i++) p_query.AddPoint(p_space.m_batchIDs[i], p_space.m_batchDists[i]);
+            }
+            p_query.SortResult();
+        }
+
         template<typename T>
         ErrorCode
             Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
+            const SearchOptions& options = p_query.GetSearchOptions();
+            p_searchDeleted = p_searchDeleted || options.m_searchDeleted;
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_iMaxCheck, p_query.GetResultNum());
+            workSpace->Reset(SearchOptions::Pick(options.m_maxCheck, m_iMaxCheck), p_query.GetResultNum());
 
             COMMON::QueryResultSet<T>* p_results = (COMMON::QueryResultSet<T>*) & p_query;
 
@@ -224,6 +278,103 @@ case VectorValueType::Name: \
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            p_results.clear();
+            if (p_maxResults <= 0) return ErrorCode::Success;
+
+            // Every vector in range is visited, so the visited table is sized for p_maxResults; the budget
+            // for nodes out of range stays at MaxCheck.
+            auto workSpace = m_workSpacePool->Rent();
+            workSpace->Reset(max(m_iMaxCheck, min(p_maxResults, (int)m_pSamples.R())), 1);
+            workSpace->m_iMaxCheck = m_iMaxCheck;
+
+            COMMON::QueryResultSet<T> query((const T*)p_vector, 1);
+            if (m_pQuantizer)
+            {
+                query.SetTarget((const T*)p_vector, m_pQuantizer);
+                switch (m_pQuantizer->GetReconstructType())
+                {
+#define DefineVectorValueType(Name, Type) \
+case VectorValueType::Name: \
+                SearchIndexRange<Type>(query, *workSpace, p_radius, p_maxResults, p_results, p_searchDeleted); \
+                break; \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+                default: break;
+                }
+            }
+            else
+            {
+                SearchIndexRange<T>(query, *workSpace, p_radius, p_maxResults, p_results, p_searchDeleted);
+            }
+
+            m_workSpacePool->Return(workSpace);
+
+            std::sort(p_results.begin(), p_results.end(), COMMON::Compare);
+            if (p_withMeta && nullptr != m_pMetadata)
+            {
+                for (BasicResult& res : p_results) res.Meta = m_pMetadata->GetMetadataCopy(res.VID);
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::SearchIndexRange(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_searchDeleted) const
+        {
+            const bool checkDeleted = !p_searchDeleted && m_deletedID.Count() > 0;
+
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            m_pTrees.InitSearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space);
+            m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfInitialDynamicPivots);
+            p_space.ReserveBatch(m_pGraph.m_iNeighborhoodSize);
+            while (!p_space.m_NGQueue.empty()) {
+                NodeDistPair gnode = p_space.m_NGQueue.pop();
+                const SizeType *node = m_pGraph[gnode.node];
+                _mm_prefetch((const char *)node, _MM_HINT_T0);
+                if (gnode.distance <= p_radius) {
+                    if (!checkDeleted || !m_deletedID.Contains(gnode.node)) {
+                        p_results.emplace_back(gnode.node, gnode.distance);
+                        if ((int)p_results.size() >= p_maxResults) return;
+                    }
+                }
+                else if (p_space.m_iNumberOfCheckedLeaves > p_space.m_iMaxCheck) {
+                    return;
+                }
+                float upperBound = max(p_radius, gnode.distance);
+                bool bLocalOpt = true;
+                int batchCount = 0;
+                for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize; i++) {
+                    SizeType nn_index = node[i];
+                    if (nn_index < 0) break;
+                    if (p_space.CheckAndSet(nn_index)) continue;
+                    p_space.m_batchIDs[batchCount++] = nn_index;
+                }
+                ComputeDistanceBatch(p_query.GetQuantizedTarget(), p_space.m_batchIDs.data(), batchCount, p_space.m_batchDists.data());
+                for (int i = 0; i < batchCount; i++) {
+                    float distance2leaf = p_space.m_batchDists[i];
+                    if (distance2leaf <= upperBound) bLocalOpt = false;
+                    p_space.m_iNumberOfCheckedLeaves++;
+                    p_space.m_NGQueue.insert(NodeDistPair(p_space.m_batchIDs[i], distance2leaf));
+                }
+                if (bLocalOpt) p_space.m_iNumOfContinuousNoBetterPropagation++;
+                else p_space.m_iNumOfContinuousNoBetterPropagation = 0;
+                if (p_space.m_iNumOfContinuousNoBetterPropagation > m_iThresholdOfNumberOfContinuousNoBetterPropagation) {
+                    if (p_space.m_iNumberOfTreeCheckedLeaves <= p_space.m_iNumberOfCheckedLeaves / 10) {
+                        m_pTrees.SearchTrees<T,Q>(m_pSamples, m_fComputeDistance, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves);
+                    } else if (gnode.distance > p_radius) {
+                        break;
+                    }
+                }
+            }
+        }
+
         template <typename T>
         ErrorCode Index<T>::RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
@@ -311,8 +462,10 @@ case VectorValueType::Name: \
 
             omp_set_num_threads(m_iNumberOfThreads);
 
+            SelectHugePages();
             m_pSamples.Initialize(p_vectorNum, p_dimension, m_iDataBlockSize, m_iDataCapacity, (T*)p_data, p_shareOwnership);
             m_deletedID.Initialize(p_vectorNum, m_iDataBlockSize, m_iDataCapacity);
+            SelectDistanceFunction();
 
             if (DistCalcMethod::Cosine == m_iDistCalcMethod && !p_normalized)
             {
@@ -324,7 +477,7 @@ case VectorValueType::Name: \
             }
 
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             m_threadPool.init();
 
             auto t1 = std::chrono::high_resolution_clock::now();
@@ -378,11 +531,13 @@ case VectorValueType::Name: \
             if (newR == 0) return ErrorCode::EmptyIndex;
 
             ptr->m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            ptr->m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            ptr->m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             ptr->m_threadPool.init();
 
             ErrorCode ret = ErrorCode::Success;
+            ptr->SelectHugePages();
             if ((ret = m_pSamples.Refine(indices, ptr->m_pSamples)) != ErrorCode::Success) return ret;
+            ptr->SelectDistanceFunction();
             if (nullptr != m_pMetadata && (ret = m_pMetadata->RefineMetadata(indices, ptr->m_pMetadata, m_iDataBlockSize, m_iDataCapacity, m_iMetaRecordSize)) != ErrorCode::Success) return ret;
 
             ptr->m_deletedID.Initialize(newR, m_iDataBlockSize, m_iDataCapacity);
@@ -554,9 +709,10 @@ case VectorValueType::Name: \
         ErrorCode
             Index<T>::UpdateIndex()
         {
+            SelectDistanceFunction();
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<COMMON::WorkSpace>());
-            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp);
+            m_workSpacePool->Init(m_iNumberOfThreads, max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), m_iHashTableExp, m_iHeapArity);
             return ErrorCode::Success;
         }
 
@@ -581,7 +737,7 @@ case VectorValueType::Name: \
 #undef DefineKDTParameter
 
             if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, "DistCalcMethod")) {
-                m_fComputeDistance = m_pQuantizer ? m_pQuantizer->DistanceCalcSelector<T>(m_iDistCalcMethod) : COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
+                SelectDistanceFunction();
                 auto base = m_pQuantizer ? m_pQuantizer->GetBase() : COMMON::Utils::GetBase<T>();
                 m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? base * base : 1;
             }
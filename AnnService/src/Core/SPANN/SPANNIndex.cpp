@@ -43,7 +43,7 @@ namespace SPTAG
             }
             else
             {
-                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod);
+                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod, m_options.m_dim);
                 m_iBaseSquare = (m_options.m_distCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<std::uint8_t>() * COMMON::Utils::GetBase<std::uint8_t>() : 1;
             }  
             if (m_index)
@@ -100,6 +100,8 @@ namespace SPTAG
 
             m_vectorTranslateMap.reset((std::uint64_t*)(p_indexBlobs.back().Data()), [=](std::uint64_t* ptr) {});
            
+            if (!m_pQuantizer) m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod, m_options.m_dim);
+
             omp_set_num_threads(m_options.m_iSSDNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<ExtraWorkSpace>());
             m_workSpacePool->Init(m_options.m_iSSDNumberOfThreads, m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, max(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, int(m_options.m_enableDataCompression));
@@ -132,6 +134,8 @@ namespace SPTAG
             m_vectorTranslateMap.reset(new std::uint64_t[m_index->GetNumSamples()], std::default_delete<std::uint64_t[]>());
             IOBINARY(p_indexStreams[m_index->GetIndexFiles()->size()], ReadBinary, sizeof(std::uint64_t) * m_index->GetNumSamples(), reinterpret_cast<char*>(m_vectorTranslateMap.get()));
 
+            if (!m_pQuantizer) m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod, m_options.m_dim);
+
             omp_set_num_threads(m_options.m_iSSDNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool<ExtraWorkSpace>());
             m_workSpacePool->Init(m_options.m_iSSDNumberOfThreads, m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, max(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, int(m_options.m_enableDataCompression));
@@ -195,13 +199,22 @@ namespace SPTAG
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
+            int internalResultNum = GetInternalResultNum(p_query);
             COMMON::QueryResultSet<T>* p_queryResults;
-            if (p_query.GetResultNum() >= m_options.m_searchInternalResultNum) 
+            if (p_query.GetResultNum() >= internalResultNum) 
                 p_queryResults = (COMMON::QueryResultSet<T>*) & p_query;
             else
-                p_queryResults = new COMMON::QueryResultSet<T>((const T*)p_query.GetTarget(), m_options.m_searchInternalResultNum);
+            {
+                p_queryResults = new COMMON::QueryResultSet<T>((const T*)p_query.GetTarget(), internalResultNum);
+                p_queryResults->SetTerminationPolicy(p_query.GetTerminationPolicy());
+                p_queryResults->SetSearchOptions(p_query.GetSearchOptions());
+            }
 
+            // The filter applies to vector ids, not to the head ids returned by the head index.
+            std::shared_ptr<const IFilter> filter = p_query.GetFilter();
+            if (filter != nullptr) p_queryResults->SetFilter(nullptr);
             m_index->SearchIndex(*p_queryResults);
+            if (filter != nullptr) p_queryResults->SetFilter(filter);
             
             std::shared_ptr<ExtraWorkSpace> workSpace = nullptr;
             if (m_extraSearcher != nullptr) {
@@ -223,20 +236,21 @@ namespace SPTAG
                     }
 
                     // Don't do disk reads for irrelevant pages
-                    if (workSpace->m_postingIDs.size() >= m_options.m_searchInternalResultNum || 
+                    if (workSpace->m_postingIDs.size() >= internalResultNum || 
                         (limitDist > 0.1 && res->Dist > limitDist) || 
                         !m_extraSearcher->CheckValidPosting(postingID)) 
                         continue;
                     workSpace->m_postingIDs.emplace_back(postingID);
                 }
 
+                if (filter != nullptr) FilterHeads(*p_queryResults, *filter);
                 p_queryResults->Reverse();
                 m_extraSearcher->SearchIndex(workSpace.get(), *p_queryResults, m_index, nullptr);
                 m_workSpacePool->Return(workSpace);
                 p_queryResults->SortResult();
             }
 
-            if (p_query.GetResultNum() < m_options.m_searchInternalResultNum) {
+            if (p_query.GetResultNum() < internalResultNum) {
                 std::copy(p_queryResults->GetResults(), p_queryResults->GetResults() + p_query.GetResultNum(), p_query.GetResults());
                 delete p_queryResults;
             }
@@ -252,6 +266,29 @@ namespace SPTAG
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            p_results.clear();
+            if (p_maxResults <= 0) return ErrorCode::Success;
+
+            // The picked postings are scanned in full whatever the result count, so one search with room
+            // for p_maxResults finds every vector in range that they hold.
+            QueryResult query(p_vector, min(p_maxResults, (int)GetNumSamples()), p_withMeta);
+            ErrorCode ret = SearchIndex(query, p_searchDeleted);
+            if (ret != ErrorCode::Success) return ret;
+
+            for (int i = 0; i < query.GetResultNum(); ++i)
+            {
+                BasicResult* res = query.GetResult(i);
+                if (res->VID < 0 || res->Dist > p_radius) break;
+                p_results.push_back(*res);
+            }
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::SearchDiskIndex(QueryResult& p_query, SearchStats* p_stats) const
         {
@@ -262,9 +299,11 @@ namespace SPTAG
             workSpace->m_deduper.clear();
             workSpace->m_postingIDs.clear();
 
+            int internalResultNum = GetInternalResultNum(p_query);
+            const IFilter* filter = p_query.GetFilter().get();
             float limitDist = p_queryResults->GetResult(0)->Dist * m_options.m_maxDistRatio;
             int i = 0;
-            for (; i < m_options.m_searchInternalResultNum; ++i)
+            for (; i < internalResultNum; ++i)
             {
                 auto res = p_queryResults->GetResult(i);
                 if (res->VID == -1 || (limitDist > 0.1 && res->Dist > limitDist)) break;
@@ -292,6 +331,7 @@ namespace SPTAG
                 }
             }
 
+            if (filter != nullptr) FilterHeads(*p_queryResults, *filter);
             p_queryResults->Reverse();
             m_extraSearcher->SearchIndex(workSpace.get(), *p_queryResults, m_index, p_stats);
             m_workSpacePool->Return(workSpace);
@@ -780,6 +820,7 @@ namespace SPTAG
                 m_workSpacePool.reset(new COMMON::WorkSpacePool<ExtraWorkSpace>());
                 m_workSpacePool->Init(m_options.m_iSSDNumberOfThreads, m_options.m_maxCheck, m_options.m_hashExp, m_options.m_searchInternalResultNum, max(m_options.m_postingPageLimit, m_options.m_searchPostingPageLimit + 1) << PageSizeEx, int(m_options.m_enableDataCompression));
             }
+            if (!m_pQuantizer) m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod, m_options.m_dim);
             m_bReady = true;
             return ErrorCode::Success;
         }
@@ -869,7 +910,7 @@ namespace SPTAG
                 }
                 else
                 {
-                    m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod);
+                    m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_options.m_distCalcMethod, m_options.m_dim);
                     m_iBaseSquare = (m_options.m_distCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
                 }
             }
@@ -439,6 +439,18 @@ VectorIndex::SearchIndex(const void* p_vector, int p_vectorCount, int p_neighbor
 }
 
 
+ErrorCode
+VectorIndex::SearchIndexRange(const void* p_vector, float p_radius, int p_maxResults, std::vector<BasicResult>& p_results, bool p_withMeta, bool p_searchDeleted) const {
+    return ErrorCode::Undefined;
+}
+
+
+void
+VectorIndex::ComputeDistanceBatch(const void* pX, const SizeType* pIDs, int count, float* pDist) const {
+    for (int i = 0; i < count; i++) pDist[i] = ComputeDistance(pX, GetSample(pIDs[i]));
+}
+
+
 ErrorCode 
 VectorIndex::AddIndex(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex, bool p_normalized) {
     if (nullptr == p_vectorSet || p_vectorSet->GetValueType() != GetVectorValueType())
@@ -591,7 +603,7 @@ VectorIndex::CreateInstance(IndexAlgoType p_algo, VectorValueType p_valuetype)
 
 
 ErrorCode
-VectorIndex::LoadIndex(const std::string& p_loaderFilePath, std::shared_ptr<VectorIndex>& p_vectorIndex)
+VectorIndex::LoadIndex(const std::string& p_loaderFilePath, std::shared_ptr<VectorIndex>& p_vectorIndex, bool p_memoryMapped, bool p_populate)
 {
     std::string folderPath(p_loaderFilePath);
     if (!folderPath.empty() && *(folderPath.rbegin()) != FolderSep) folderPath += FolderSep;
@@ -628,9 +640,28 @@ VectorIndex::LoadIndex(const std::string& p_loaderFilePath, std::shared_ptr<Vect
         handles.push_back(std::move(ptr));
     }
 
-    if ((ret = p_vectorIndex->LoadIndexData(handles)) != ErrorCode::Success) return ret;
-
     size_t metaStart = p_vectorIndex->GetIndexFiles()->size();
+    if (p_memoryMapped && algoType != IndexAlgoType::SPANN)
+    {
+        // Samples, graph and deleted IDs point straight into the mappings; a missing deleted ID file is optional.
+        std::vector<ByteArray> blobs;
+        for (size_t i = 0; i < metaStart; i++) {
+            std::shared_ptr<Helper::MemoryMappedFile> mapped(new Helper::MemoryMappedFile());
+            if (!mapped->Initialize((folderPath + (*indexfiles)[i]).c_str(), p_populate)) {
+                LOG(Helper::LogLevel::LL_Error, "Cannot map file %s!\n", (folderPath + (*indexfiles)[i]).c_str());
+                break;
+            }
+            blobs.push_back(ByteArray((std::uint8_t*)mapped->Data(), mapped->Size(), false));
+            p_vectorIndex->m_pMappedFiles.push_back(std::move(mapped));
+        }
+        if ((ret = p_vectorIndex->LoadIndexDataFromMemory(blobs)) != ErrorCode::Success) return ret;
+    }
+    else
+    {
+        if (p_memoryMapped) LOG(Helper::LogLevel::LL_Warning, "Memory mapped loading is not supported for SPANN, reading the index files instead.\n");
+        if ((ret = p_vectorIndex->LoadIndexData(handles)) != ErrorCode::Success) return ret;
+    }
+
     if (iniReader.DoesSectionExist("MetaData"))
     {
         p_vectorIndex->SetMetadata(new MemMetadataSet(handles[metaStart], handles[metaStart + 1], 
@@ -832,6 +863,7 @@ void VectorIndex::ApproximateRNG(std::shared_ptr<VectorSet>& fullVectors, std::u
     }
     else if(GetVectorValueType() != VectorValueType::Float) {
         typedef int32_t SUMTYPE;
+        // The GPU kernels accumulate integer types in int32; half precision vectors are not supported there.
         switch (GetVectorValueType())
         {
 #define DefineVectorValueType(Name, Type) \
@@ -839,10 +871,14 @@ void VectorIndex::ApproximateRNG(std::shared_ptr<VectorSet>& fullVectors, std::u
             getTailNeighborsTPT<Type, SUMTYPE>((Type*)fullVectors->GetData(), fullVectors->Count(), this, exceptIDS, fullVectors->Dimension(), replicaCount, numThreads, numTrees, leafSize, metric, numGPUs, selections); \
             break; 
 
-#include "inc/Core/DefinitionList.h"
+        DefineVectorValueType(Int8, std::int8_t)
+        DefineVectorValueType(UInt8, std::uint8_t)
+        DefineVectorValueType(Int16, std::int16_t)
 #undef DefineVectorValueType
 
-        default: break;
+        default:
+            LOG(Helper::LogLevel::LL_Error, "GPU SSD Index build does not support value type %s!\n", Helper::Convert::ConvertToString(GetVectorValueType()).c_str());
+            break;
         }
     }
     else {
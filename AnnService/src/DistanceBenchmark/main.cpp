@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/DistanceUtils.h"
+#include "inc/Helper/StringConvert.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace SPTAG;
+
+template <typename T>
+static double TimeKernel(COMMON::DistanceCalcReturn<T> func, const std::vector<T>& query, const std::vector<T>& data, DimensionType dim, SizeType rows, int rounds, float& checksum)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (SizeType i = 0; i < rows; i++)
+        {
+            checksum += func(query.data(), data.data() + (size_t)i * dim, dim);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / ((double)rows * rounds);
+}
+
+template <typename T>
+static void Benchmark(const char* typeName, int high, SizeType rows, int rounds)
+{
+    for (DimensionType dim : { 64, 96, 128, 256, 768 })
+    {
+        std::vector<T> query(dim), data((size_t)rows * dim);
+        for (auto& v : query) v = (T)(std::rand() % (2 * high + 1) - high);
+        for (auto& v : data) v = (T)(std::rand() % (2 * high + 1) - high);
+
+        for (DistCalcMethod method : { DistCalcMethod::L2, DistCalcMethod::Cosine })
+        {
+            float checksum = 0;
+            double generic = TimeKernel<T>(COMMON::DistanceCalcSelector<T>(method), query, data, dim, rows, rounds, checksum);
+            double fixed = TimeKernel<T>(COMMON::DistanceCalcSelector<T>(method, dim), query, data, dim, rows, rounds, checksum);
+            LOG(Helper::LogLevel::LL_Info, "%s\t%d\t%s\tgeneric(ns): %.2lf\tfixed(ns): %.2lf\tspeedup: %.2lf\t(checksum %f)\n",
+                typeName, dim, Helper::Convert::ConvertToString(method).c_str(), generic, fixed, generic / fixed, checksum);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    SizeType rows = (argc > 1) ? std::atoi(argv[1]) : 10000;
+    int rounds = (argc > 2) ? std::atoi(argv[2]) : 20;
+
+    LOG(Helper::LogLevel::LL_Info, "type\tdim\tmethod\tper-call latency over %d rows x %d rounds\n", rows, rounds);
+    Benchmark<float>("float", 1, rows, rounds);
+    Benchmark<std::int8_t>("int8", 127, rows, rounds);
+    Benchmark<std::uint8_t>("uint8", 127, rows, rounds);
+    Benchmark<std::int16_t>("int16", 32767, rows, rounds);
+    Benchmark<Float16>("float16", 1, rows, rounds);
+    Benchmark<BFloat16>("bfloat16", 1, rows, rounds);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Helper/HugePageAllocator.h"
+#include "inc/Core/Common.h"
+
+#include <atomic>
+
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#endif
+
+namespace SPTAG
+{
+    namespace Helper
+    {
+#ifndef _MSC_VER
+        namespace
+        {
+            const std::size_t c_page2M = ((std::size_t)1) << 21;
+            const std::size_t c_page1G = ((std::size_t)1) << 30;
+
+            std::atomic<bool> s_warnedFallback(false);
+
+            inline std::size_t RoundUp(std::size_t p_size, std::size_t p_page)
+            {
+                return (p_size + p_page - 1) & ~(p_page - 1);
+            }
+
+            void* MapHugeTLB(std::size_t p_size, std::size_t p_page, int p_shift)
+            {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+                void* ptr = mmap(nullptr, RoundUp(p_size, p_page), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (p_shift << MAP_HUGE_SHIFT), -1, 0);
+                if (ptr != MAP_FAILED) return ptr;
+#endif
+                return nullptr;
+            }
+        }
+
+        void* HugePageAlloc(std::size_t p_size, HugePageMode p_mode, std::size_t& p_allocated)
+        {
+            p_allocated = 0;
+            if (p_mode == HugePageMode::None || p_size < c_page2M) return nullptr;
+
+            void* ptr;
+            if (p_mode == HugePageMode::Page1G && p_size >= c_page1G && (ptr = MapHugeTLB(p_size, c_page1G, 30)) != nullptr) {
+                p_allocated = RoundUp(p_size, c_page1G);
+                return ptr;
+            }
+            if ((ptr = MapHugeTLB(p_size, c_page2M, 21)) != nullptr) {
+                p_allocated = RoundUp(p_size, c_page2M);
+                return ptr;
+            }
+
+            if (!s_warnedFallback.exchange(true)) {
+                LOG(Helper::LogLevel::LL_Warning, "No hugetlb pages available, falling back to transparent huge pages.\n");
+            }
+
+            // Over-map by one huge page so that the region can be trimmed to a 2 MB boundary,
+            // otherwise the kernel cannot back its edges with transparent huge pages.
+            std::size_t size = RoundUp(p_size, c_page2M);
+            char* raw = (char*)mmap(nullptr, size + c_page2M, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) return nullptr;
+
+            char* aligned = (char*)RoundUp((std::size_t)raw, c_page2M);
+            if (aligned > raw) munmap(raw, aligned - raw);
+            if (raw + c_page2M > aligned) munmap(aligned + size, raw + c_page2M - aligned);
+#ifdef MADV_HUGEPAGE
+            madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+            p_allocated = size;
+            return aligned;
+        }
+
+        void HugePageFree(void* p_ptr, std::size_t p_allocated)
+        {
+            if (p_ptr != nullptr && p_allocated > 0) munmap(p_ptr, p_allocated);
+        }
+#else
+        void* HugePageAlloc(std::size_t p_size, HugePageMode p_mode, std::size_t& p_allocated)
+        {
+            // Large pages need SeLockMemoryPrivilege on Windows; use the default allocator instead.
+            p_allocated = 0;
+            return nullptr;
+        }
+
+        void HugePageFree(void* p_ptr, std::size_t p_allocated) {}
+#endif
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Helper/MemoryMappedFile.h"
+
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SPTAG::Helper;
+
+#ifdef _MSC_VER
+MemoryMappedFile::MemoryMappedFile() : m_data(nullptr), m_size(0), m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(nullptr) {}
+#else
+MemoryMappedFile::MemoryMappedFile() : m_data(nullptr), m_size(0) {}
+#endif
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    ShutDown();
+}
+
+#ifdef _MSC_VER
+bool MemoryMappedFile::Initialize(const char* p_filePath, bool p_populate)
+{
+    ShutDown();
+    m_fileHandle = CreateFileA(p_filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_fileHandle, &size) || size.QuadPart == 0) { ShutDown(); return false; }
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (m_mappingHandle == nullptr) { ShutDown(); return false; }
+
+    m_data = (char*)MapViewOfFile(m_mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+    if (m_data == nullptr) { ShutDown(); return false; }
+    m_size = (std::uint64_t)size.QuadPart;
+
+    if (p_populate) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = m_data;
+        range.NumberOfBytes = (SIZE_T)m_size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+    return true;
+}
+
+void MemoryMappedFile::ShutDown()
+{
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mappingHandle != nullptr) CloseHandle(m_mappingHandle);
+    if (m_fileHandle != INVALID_HANDLE_VALUE) CloseHandle(m_fileHandle);
+    m_data = nullptr;
+    m_size = 0;
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+}
+#else
+bool MemoryMappedFile::Initialize(const char* p_filePath, bool p_populate)
+{
+    ShutDown();
+    int fd = open(p_filePath, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (p_populate) flags |= MAP_POPULATE;
+#endif
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    m_data = (char*)addr;
+    m_size = (std::uint64_t)st.st_size;
+    if (!p_populate) madvise(m_data, (size_t)m_size, MADV_RANDOM);
+    return true;
+}
+
+void MemoryMappedFile::ShutDown()
+{
+    if (m_data != nullptr) munmap(m_data, (size_t)m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+#endif
@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Helper/Numa.h"
+#include "inc/Helper/CommonHelper.h"
+#include "inc/Helper/StringConvert.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace SPTAG;
+
+namespace
+{
+#ifdef __linux__
+    // Mirrors of the <numaif.h> constants, so libnuma is not needed at build or run time.
+    const int c_mpolBind = 2;
+    const int c_mpolInterleave = 3;
+    const unsigned c_mpolMoveFlag = 1 << 1;
+    const int c_maxNodes = 1024;
+
+    struct Topology
+    {
+        // Kernel node ids, indexed by the dense node numbers handed out by this module.
+        std::vector<int> m_nodeIds;
+        std::vector<std::vector<int>> m_nodeCpus;
+        std::vector<int> m_cpuToNode;
+
+        Topology()
+        {
+            std::vector<int> ids = ReadList("/sys/devices/system/node/online");
+            for (int id : ids)
+            {
+                if (id < 0 || id >= c_maxNodes) continue;
+                m_nodeIds.push_back(id);
+                m_nodeCpus.push_back(ReadList("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+                for (int cpu : m_nodeCpus.back())
+                {
+                    if (cpu < 0) continue;
+                    if (cpu >= (int)m_cpuToNode.size()) m_cpuToNode.resize(cpu + 1, 0);
+                    m_cpuToNode[cpu] = (int)m_nodeIds.size() - 1;
+                }
+            }
+            if (m_nodeIds.empty())
+            {
+                m_nodeIds.push_back(0);
+                m_nodeCpus.emplace_back();
+            }
+        }
+
+        // Parses the kernel list format, e.g. "0-3,8,10-11".
+        static std::vector<int> ReadList(const std::string& p_path)
+        {
+            std::vector<int> res;
+            std::ifstream input(p_path);
+            std::string line;
+            if (!input.is_open() || !std::getline(input, line)) return res;
+
+            for (const auto& range : Helper::StrUtils::SplitString(line, ", \n"))
+            {
+                auto dash = range.find('-');
+                int first = 0, last = 0;
+                if (!Helper::Convert::ConvertStringTo<int>(range.substr(0, dash).c_str(), first)) continue;
+                if (dash == std::string::npos) last = first;
+                else if (!Helper::Convert::ConvertStringTo<int>(range.substr(dash + 1).c_str(), last)) continue;
+                for (int i = first; i <= last; i++) res.push_back(i);
+            }
+            return res;
+        }
+    };
+
+    const Topology& GetTopology()
+    {
+        static Topology topology;
+        return topology;
+    }
+
+    bool MBind(void* p_ptr, std::size_t p_size, int p_mode, const std::vector<int>& p_nodeIds)
+    {
+#ifdef SYS_mbind
+        std::size_t pageSize = (std::size_t)sysconf(_SC_PAGESIZE);
+        std::size_t begin = ((std::size_t)p_ptr + pageSize - 1) & ~(pageSize - 1);
+        std::size_t end = ((std::size_t)p_ptr + p_size) & ~(pageSize - 1);
+        if (end <= begin) return true;
+
+        const int bits = 8 * sizeof(unsigned long);
+        unsigned long mask[c_maxNodes / bits] = { 0 };
+        for (int id : p_nodeIds) mask[id / bits] |= 1UL << (id % bits);
+        return syscall(SYS_mbind, begin, end - begin, p_mode, mask, (unsigned long)c_maxNodes + 1, c_mpolMoveFlag) == 0;
+#else
+        return false;
+#endif
+    }
+#endif
+}
+
+int Helper::Numa::NodeCount()
+{
+#ifdef __linux__
+    return (int)GetTopology().m_nodeIds.size();
+#else
+    return 1;
+#endif
+}
+
+int Helper::Numa::CurrentNode()
+{
+#ifdef __linux__
+    const Topology& topology = GetTopology();
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= (int)topology.m_cpuToNode.size()) return 0;
+    return topology.m_cpuToNode[cpu];
+#else
+    return 0;
+#endif
+}
+
+bool Helper::Numa::Interleave(void* p_ptr, std::size_t p_size)
+{
+#ifdef __linux__
+    return MBind(p_ptr, p_size, c_mpolInterleave, GetTopology().m_nodeIds);
+#else
+    return false;
+#endif
+}
+
+bool Helper::Numa::Bind(void* p_ptr, std::size_t p_size, int p_node)
+{
+#ifdef __linux__
+    const Topology& topology = GetTopology();
+    if (p_node < 0 || p_node >= (int)topology.m_nodeIds.size()) return false;
+    return MBind(p_ptr, p_size, c_mpolBind, std::vector<int>(1, topology.m_nodeIds[p_node]));
+#else
+    return false;
+#endif
+}
+
+bool Helper::Numa::PinThread(int p_node)
+{
+#ifdef __linux__
+    const Topology& topology = GetTopology();
+    if (p_node < 0 || p_node >= (int)topology.m_nodeCpus.size() || topology.m_nodeCpus[p_node].empty()) return false;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : topology.m_nodeCpus[p_node])
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+    }
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+    return false;
+#endif
+}
@@ -39,6 +39,7 @@ public:
         AddOptionalOption(m_debugQuery, "-q", "--debugquery", "Debug query number.");
         AddOptionalOption(m_enableADC, "-adc", "--adc", "Enable ADC Distance computation");
         AddOptionalOption(m_outputformat, "-of", "--ouputformat", "0: TXT 1: BINARY.");
+        AddOptionalOption(m_memoryMapped, "-mm", "--memorymapped", "0: read index files 1: memory map them 2: memory map and prefault.");
     }
 
     ~SearcherOptions() {}
@@ -59,6 +60,8 @@ public:
 
     int m_withMeta = 0;
 
+    int m_memoryMapped = 0;
+
     int m_K = 32;
 
     int m_truthK = -1;
@@ -346,7 +349,7 @@ int main(int argc, char** argv)
     }
 
     std::shared_ptr<SPTAG::VectorIndex> vecIndex;
-    auto ret = SPTAG::VectorIndex::LoadIndex(options->m_indexFolder, vecIndex);
+    auto ret = SPTAG::VectorIndex::LoadIndex(options->m_indexFolder, vecIndex, options->m_memoryMapped > 0, options->m_memoryMapped > 1);
     if (SPTAG::ErrorCode::Success != ret || nullptr == vecIndex)
     {
         LOG(Helper::LogLevel::LL_Error, "Cannot open index configure file!");
@@ -6,8 +6,11 @@
 #include "inc/Socket/RemoteSearchQuery.h"
 #include "inc/Helper/CommonHelper.h"
 #include "inc/Helper/ArgumentsParser.h"
+#include "inc/Helper/Numa.h"
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 
 using namespace SPTAG;
 using namespace SPTAG::Service;
@@ -124,6 +127,10 @@ SearchService::RunSocketMode()
 {
     auto threadNum = max((SizeType)1, m_serviceContext->GetServiceSettings()->m_threadNum);
     m_threadPool.reset(new boost::asio::thread_pool(threadNum));
+    if (m_serviceContext->GetServiceSettings()->m_numaPinThreads)
+    {
+        PinThreadsToNuma(threadNum);
+    }
 
     Socket::PacketHandlerMapPtr handlerMap(new Socket::PacketHandlerMap);
     handlerMap->emplace(Socket::PacketType::SearchRequest,
@@ -162,6 +169,38 @@ SearchService::RunSocketMode()
 }
 
 
+void
+SearchService::PinThreadsToNuma(SizeType p_threadNum)
+{
+    // Every task blocks until all of them have started, so each pool thread runs exactly one.
+    struct PinState
+    {
+        std::mutex m_lock;
+        std::condition_variable m_allStarted;
+        SizeType m_started = 0;
+        SizeType m_pinned = 0;
+    };
+    auto state = std::make_shared<PinState>();
+    int nodes = Helper::Numa::NodeCount();
+
+    for (SizeType i = 0; i < p_threadNum; i++)
+    {
+        boost::asio::post(*m_threadPool, [state, p_threadNum, nodes, i]()
+                          {
+                              bool pinned = Helper::Numa::PinThread(i % nodes);
+                              std::unique_lock<std::mutex> lock(state->m_lock);
+                              if (pinned) state->m_pinned++;
+                              if (++state->m_started == p_threadNum) state->m_allStarted.notify_all();
+                              else state->m_allStarted.wait(lock, [&]() { return state->m_started == p_threadNum; });
+                          });
+    }
+
+    std::unique_lock<std::mutex> lock(state->m_lock);
+    state->m_allStarted.wait(lock, [&]() { return state->m_started == p_threadNum; });
+    LOG(Helper::LogLevel::LL_Info, "Pinned %d of %d search threads over %d NUMA nodes.\n", (int)state->m_pinned, (int)p_threadNum, nodes);
+}
+
+
 void
 SearchService::RunInteractiveMode()
 {
@@ -25,6 +25,7 @@ ServiceContext::ServiceContext(const std::string& p_configFilePath)
     m_settings->m_listenPort = iniReader.GetParameter("Service", "ListenPort", std::string("8000"));
     m_settings->m_threadNum = iniReader.GetParameter("Service", "ThreadNumber", static_cast<std::uint32_t>(8));
     m_settings->m_socketThreadNum = iniReader.GetParameter("Service", "SocketThreadNumber", static_cast<std::uint32_t>(8));
+    m_settings->m_numaPinThreads = iniReader.GetParameter("Service", "NumaPinThreads", false);
 
     m_settings->m_defaultMaxResultNumber = iniReader.GetParameter("QueryConfig", "DefaultMaxResultNumber", static_cast<SizeType>(10));
     m_settings->m_vectorSeparator = iniReader.GetParameter("QueryConfig", "DefaultSeparator", std::string("|"));
@@ -44,9 +45,11 @@ ServiceContext::ServiceContext(const std::string& p_configFilePath)
         }
 
         std::string indexFolder = iniReader.GetParameter(sectionName, "IndexFolder", emptyStr);
+        bool memoryMapped = iniReader.GetParameter(sectionName, "MemoryMapped", false);
+        bool populate = iniReader.GetParameter(sectionName, "PopulateMemoryMap", false);
 
         std::shared_ptr<VectorIndex> vectorIndex;
-        if (ErrorCode::Success == VectorIndex::LoadIndex(indexFolder, vectorIndex))
+        if (ErrorCode::Success == VectorIndex::LoadIndex(indexFolder, vectorIndex, memoryMapped, populate))
         {
             vectorIndex->SetIndexName(indexName);
             m_fullIndexList.emplace(indexName, vectorIndex);
@@ -9,6 +9,7 @@ using namespace SPTAG::Service;
 
 ServiceSettings::ServiceSettings()
     : m_defaultMaxResultNumber(10),
-      m_threadNum(12)
+      m_threadNum(12),
+      m_numaPinThreads(false)
 {
 }
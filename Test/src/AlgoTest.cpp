@@ -5,9 +5,15 @@
 #include "inc/Helper/SimpleIniReader.h"
 #include "inc/Core/VectorIndex.h"
 #include "inc/Core/Common/CommonUtils.h"
+#include "inc/Core/Common/DistanceUtils.h"
+#include "inc/Core/Common/TerminationPolicy.h"
 
+#include <algorithm>
+#include <atomic>
 #include <unordered_set>
 #include <chrono>
+#include <fstream>
+#include <thread>
 
 template <typename T>
 void Build(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::shared_ptr<SPTAG::VectorSet>& vec, std::shared_ptr<SPTAG::MetadataSet>& meta, const std::string out)
@@ -225,6 +231,769 @@ void Test(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
     }
 }
 
+template <typename T>
+void BatchSearch(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000, q = 64;
+    SPTAG::DimensionType m = 16;
+    int k = 5;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) {
+        vec.push_back((T)(rand() % 100));
+    }
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    std::vector<SPTAG::BasicResult> single(q * k), batch(q * k);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        SPTAG::QueryResult res(vec.data() + i * m, k, false, single.data() + i * k);
+        vecIndex->SearchIndex(res);
+    }
+
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SetParameter("BatchSearchSize", "16"));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(vec.data(), q, k, false, batch.data()));
+    for (SPTAG::SizeType i = 0; i < q * k; i++)
+    {
+        BOOST_CHECK_EQUAL(single[i].VID, batch[i].VID);
+        BOOST_CHECK_CLOSE(single[i].Dist, batch[i].Dist, 1e-4);
+    }
+}
+
+template <typename T>
+void InnerProductSearch(const std::string& mipsTransform)
+{
+    SPTAG::SizeType n = 2000, q = 32;
+    SPTAG::DimensionType m = 16;
+    int k = 5;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) {
+        // Scale rows differently so that the inner product ranking is not the cosine one.
+        vec.push_back((T)((rand() % 50 - 25) * (1 + (i / m) % 4)));
+    }
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 50 - 25));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::BKT, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "InnerProduct");
+    vecIndex->SetParameter("MIPSTransform", mipsTransform);
+    vecIndex->SetParameter("MaxCheck", "512");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    int hits = 0;
+    std::vector<SPTAG::BasicResult> results(k);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        const T* target = query.data() + i * m;
+        std::vector<std::pair<float, SPTAG::SizeType>> truth(n);
+        for (SPTAG::SizeType j = 0; j < n; j++) {
+            float dot = 0;
+            for (SPTAG::DimensionType d = 0; d < m; d++) dot += (float)target[d] * (float)vec[j * m + d];
+            truth[j] = std::make_pair(-dot, j);
+        }
+        std::partial_sort(truth.begin(), truth.begin() + k, truth.end());
+
+        SPTAG::QueryResult res(target, k, false, results.data());
+        res.Reset();
+        vecIndex->SearchIndex(res);
+        for (int j = 0; j < k; j++) {
+            BOOST_CHECK_EQUAL(vecIndex->ComputeDistance(target, vecIndex->GetSample(results[j].VID)), results[j].Dist);
+            for (int t = 0; t < k; t++) {
+                if (results[j].VID == truth[t].second) { hits++; break; }
+            }
+        }
+    }
+    float recall = (float)hits / (q * k);
+    std::cout << "InnerProduct recall@" << k << " (MIPSTransform=" << mipsTransform << "): " << recall << std::endl;
+    BOOST_CHECK(recall >= 0.9f);
+}
+
+template <typename T>
+void HeapAritySearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 20000, q = 200;
+    SPTAG::DimensionType m = 32;
+    int k = 10;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 100));
+
+    std::vector<std::vector<SPTAG::SizeType>> truth(q);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        std::vector<std::pair<float, SPTAG::SizeType>> dists(n);
+        for (SPTAG::SizeType j = 0; j < n; j++)
+            dists[j] = std::make_pair(SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query.data() + i * m, vec.data() + j * m, m), j);
+        std::partial_sort(dists.begin(), dists.begin() + k, dists.end());
+        for (int j = 0; j < k; j++) truth[i].push_back(dists[j].second);
+    }
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("MaxCheck", "2048");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    // Wider heaps only change the order of ties, so recall should match the binary heap.
+    float binaryRecall = 0;
+    std::vector<SPTAG::BasicResult> results(k);
+    for (std::string arity : { "2", "4", "8" })
+    {
+        vecIndex->SetParameter("HeapArity", arity);
+        vecIndex->UpdateIndex();
+
+        int hits = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (SPTAG::SizeType i = 0; i < q; i++)
+        {
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            vecIndex->SearchIndex(res);
+            for (int j = 0; j < k; j++)
+                if (std::find(truth[i].begin(), truth[i].end(), results[j].VID) != truth[i].end()) hits++;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        float recall = (float)hits / (q * k);
+        std::cout << "HeapArity " << arity << ": " << (std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / (float)q)
+            << "us/query, recall@" << k << ": " << recall << std::endl;
+        if (arity == "2") binaryRecall = recall;
+        BOOST_CHECK(recall >= 0.8f && recall >= binaryRecall - 0.02f);
+    }
+}
+
+template <typename T>
+void GraphReorderSearch()
+{
+    SPTAG::SizeType n = 2000, deleted = 100;
+    SPTAG::DimensionType m = 16;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 1000));
+
+    std::vector<char> meta;
+    std::vector<std::uint64_t> metaoffset;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        metaoffset.push_back((std::uint64_t)meta.size());
+        std::string a = std::to_string(i);
+        meta.insert(meta.end(), a.begin(), a.end());
+    }
+    metaoffset.push_back((std::uint64_t)meta.size());
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+    std::shared_ptr<SPTAG::MetadataSet> metaset(new SPTAG::MemMetadataSet(
+        SPTAG::ByteArray((std::uint8_t*)meta.data(), meta.size() * sizeof(char), false),
+        SPTAG::ByteArray((std::uint8_t*)metaoffset.data(), metaoffset.size() * sizeof(std::uint64_t), false),
+        n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::BKT, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("GraphReorder", "true");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, metaset));
+    for (SPTAG::SizeType i = 0; i < deleted; i++) BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->DeleteIndex(i * 3));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices_reorder"));
+    vecIndex.reset();
+
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_reorder", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex);
+    BOOST_CHECK_EQUAL(vecIndex->GetNumSamples(), n - deleted);
+
+    // Vectors are renumbered, but each one still carries its own metadata.
+    int moved = 0, found = 0;
+    for (SPTAG::SizeType i = 0; i < n; i++)
+    {
+        SPTAG::QueryResult res(vec.data() + i * m, 1, true);
+        vecIndex->SearchIndex(res);
+        std::string resmeta((char*)res.GetMetadata(0).Data(), res.GetMetadata(0).Length());
+        if (i < deleted * 3 && i % 3 == 0) {
+            BOOST_CHECK(resmeta != std::to_string(i));
+            continue;
+        }
+        if (resmeta == std::to_string(i)) found++;
+        if (res.GetResult(0)->VID != i) moved++;
+    }
+    BOOST_CHECK_EQUAL(found, n - deleted);
+    BOOST_CHECK(moved > 0);
+}
+
+template <typename T>
+void MemoryMappedSearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 2000, q = 50;
+    SPTAG::DimensionType m = 16;
+    int k = 5;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 1000));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 1000));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices_mmap"));
+
+    std::vector<std::vector<SPTAG::BasicResult>> expected(q, std::vector<SPTAG::BasicResult>(k));
+    for (SPTAG::SizeType i = 0; i < q; i++) {
+        SPTAG::QueryResult res(query.data() + i * m, k, false, expected[i].data());
+        res.Reset();
+        vecIndex->SearchIndex(res);
+    }
+    vecIndex.reset();
+
+    for (bool populate : { false, true })
+    {
+        std::shared_ptr<SPTAG::VectorIndex> mapped;
+        BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_mmap", mapped, true, populate));
+        BOOST_CHECK(nullptr != mapped);
+        BOOST_CHECK_EQUAL(mapped->GetNumSamples(), n);
+
+        std::vector<SPTAG::BasicResult> results(k);
+        for (SPTAG::SizeType i = 0; i < q; i++) {
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            mapped->SearchIndex(res);
+            for (int j = 0; j < k; j++) {
+                BOOST_CHECK_EQUAL(results[j].VID, expected[i][j].VID);
+                BOOST_CHECK_EQUAL(results[j].Dist, expected[i][j].Dist);
+            }
+        }
+
+        // Updates write into private copies of the mapped pages, never into the files.
+        BOOST_CHECK(SPTAG::ErrorCode::Success == mapped->DeleteIndex(expected[0][0].VID));
+        BOOST_CHECK(SPTAG::ErrorCode::Success == mapped->AddIndex(query.data(), 1, m, nullptr));
+        BOOST_CHECK_EQUAL(mapped->GetNumSamples(), n + 1);
+        BOOST_CHECK_EQUAL(mapped->GetNumDeleted(), 1);
+    }
+
+    std::shared_ptr<SPTAG::VectorIndex> reloaded;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_mmap", reloaded));
+    BOOST_CHECK_EQUAL(reloaded->GetNumSamples(), n);
+    BOOST_CHECK_EQUAL(reloaded->GetNumDeleted(), 0);
+}
+
+template <typename T>
+void HugePageSearch(SPTAG::IndexAlgoType algo)
+{
+    // Large enough for the vectors and the graph to span more than one 2 MB page.
+    SPTAG::SizeType n = 20000, q = 200;
+    SPTAG::DimensionType m = 32;
+    int k = 10;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 1000));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 1000));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices_hugepages"));
+
+    std::vector<std::vector<SPTAG::BasicResult>> expected(q, std::vector<SPTAG::BasicResult>(k));
+    for (SPTAG::SizeType i = 0; i < q; i++) {
+        SPTAG::QueryResult res(query.data() + i * m, k, false, expected[i].data());
+        res.Reset();
+        vecIndex->SearchIndex(res);
+    }
+    vecIndex.reset();
+
+    std::string config;
+    {
+        std::ifstream in("testindices_hugepages/indexloader.ini");
+        config.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::size_t pos = config.find("HugePages=0");
+    BOOST_REQUIRE(pos != std::string::npos);
+
+    // The page size only changes where the data lives, so every mode must return the same results.
+    std::vector<SPTAG::BasicResult> results(k);
+    for (char mode : { '0', '1', '2' })
+    {
+        config[pos + 10] = mode;
+        {
+            std::ofstream out("testindices_hugepages/indexloader.ini");
+            out << config;
+        }
+
+        std::shared_ptr<SPTAG::VectorIndex> loaded;
+        BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_hugepages", loaded));
+        BOOST_CHECK(nullptr != loaded);
+        BOOST_CHECK_EQUAL(loaded->GetParameter("HugePages"), std::string(1, mode));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (SPTAG::SizeType i = 0; i < q; i++) {
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            loaded->SearchIndex(res);
+            for (int j = 0; j < k; j++) BOOST_CHECK_EQUAL(results[j].VID, expected[i][j].VID);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "HugePages " << mode << ": " << (std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / (float)q)
+            << "us/query" << std::endl;
+
+        BOOST_CHECK(SPTAG::ErrorCode::Success == loaded->AddIndex(query.data(), 1, m, nullptr));
+        BOOST_CHECK_EQUAL(loaded->GetNumSamples(), n + 1);
+    }
+}
+
+template <typename T>
+void NumaSearch()
+{
+    SPTAG::SizeType n = 2000, q = 50;
+    SPTAG::DimensionType m = 16;
+    int k = 5;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 1000));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 1000));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(SPTAG::IndexAlgoType::BKT, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    std::vector<std::vector<SPTAG::BasicResult>> expected(q, std::vector<SPTAG::BasicResult>(k));
+    for (SPTAG::SizeType i = 0; i < q; i++) {
+        SPTAG::QueryResult res(query.data() + i * m, k, false, expected[i].data());
+        res.Reset();
+        vecIndex->SearchIndex(res);
+    }
+
+    // Replicas and interleaving only move memory around, the results stay the same.
+    std::vector<SPTAG::BasicResult> results(k);
+    auto check = [&]() {
+        for (SPTAG::SizeType i = 0; i < q; i++) {
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            vecIndex->SearchIndex(res);
+            for (int j = 0; j < k; j++) {
+                BOOST_CHECK_EQUAL(results[j].VID, expected[i][j].VID);
+                BOOST_CHECK_EQUAL(results[j].Dist, expected[i][j].Dist);
+            }
+        }
+    };
+    for (std::string mode : { "2", "1", "2" })
+    {
+        vecIndex->SetParameter("NumaMode", mode);
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->UpdateIndex());
+        check();
+    }
+
+    // Adding drops the replicas; the new vectors are found both before and after replicating again.
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->AddIndex(query.data(), q, m, nullptr));
+    for (int round = 0; round < 2; round++)
+    {
+        for (SPTAG::SizeType i = 0; i < q; i++) {
+            SPTAG::QueryResult res(query.data() + i * m, 1, false);
+            vecIndex->SearchIndex(res);
+            BOOST_CHECK_EQUAL(res.GetResult(0)->VID, n + i);
+        }
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->UpdateIndex());
+    }
+}
+
+template <typename T>
+void TerminationPolicySearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 20000, q = 200;
+    SPTAG::DimensionType m = 32;
+    int k = 10;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 100));
+
+    std::vector<std::vector<SPTAG::SizeType>> truth(q);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        std::vector<std::pair<float, SPTAG::SizeType>> dists(n);
+        for (SPTAG::SizeType j = 0; j < n; j++)
+            dists[j] = std::make_pair(SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query.data() + i * m, vec.data() + j * m, m), j);
+        std::partial_sort(dists.begin(), dists.begin() + k, dists.end());
+        for (int j = 0; j < k; j++) truth[i].push_back(dists[j].second);
+    }
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("MaxCheck", "4096");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    // Wraps a policy to count the expansions it sees and remember the seed distances.
+    class CountingPolicy : public SPTAG::COMMON::ITerminationPolicy
+    {
+    public:
+        CountingPolicy(std::shared_ptr<SPTAG::COMMON::ITerminationPolicy> p_inner) : m_inner(p_inner) {}
+
+        void Start(SPTAG::COMMON::WorkSpace& p_space) const override
+        {
+            if (!p_space.m_NGQueue.empty()) m_seedDists.push_back(p_space.m_NGQueue.Top().distance);
+            if (m_inner != nullptr) m_inner->Start(p_space);
+        }
+
+        bool Stop(SPTAG::COMMON::WorkSpace& p_space, float p_worstDist, bool p_improved) const override
+        {
+            m_expansions++;
+            return m_inner != nullptr && m_inner->Stop(p_space, p_worstDist, p_improved);
+        }
+
+        mutable std::int64_t m_expansions = 0;
+        mutable std::vector<float> m_seedDists;
+
+    private:
+        std::shared_ptr<SPTAG::COMMON::ITerminationPolicy> m_inner;
+    };
+
+    std::vector<SPTAG::BasicResult> results(k);
+    auto run = [&](const std::string& name, std::shared_ptr<CountingPolicy> policy, float& recall) {
+        int hits = 0;
+        for (SPTAG::SizeType i = 0; i < q; i++)
+        {
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            res.SetTerminationPolicy(policy);
+            vecIndex->SearchIndex(res);
+            for (int j = 0; j < k; j++)
+                if (std::find(truth[i].begin(), truth[i].end(), results[j].VID) != truth[i].end()) hits++;
+        }
+        recall = (float)hits / (q * k);
+        std::cout << name << ": " << (policy->m_expansions / (float)q) << " expansions/query, recall@" << k << ": " << recall << std::endl;
+        return policy->m_expansions;
+    };
+
+    float baseRecall = 0, patienceRecall = 0, budgetRecall = 0;
+    auto base = std::make_shared<CountingPolicy>(nullptr);
+    std::int64_t baseExpansions = run("MaxCheck only", base, baseRecall);
+    std::int64_t patienceExpansions = run("Patience", std::make_shared<CountingPolicy>(std::make_shared<SPTAG::COMMON::PatienceTermination>(48)), patienceRecall);
+
+    std::vector<float> seeds = base->m_seedDists;
+    std::nth_element(seeds.begin(), seeds.begin() + seeds.size() / 2, seeds.end());
+    std::int64_t budgetExpansions = run("SeedDistanceBudget", std::make_shared<CountingPolicy>(std::make_shared<SPTAG::COMMON::SeedDistanceBudget>(seeds[seeds.size() / 2], 0.25f)), budgetRecall);
+
+    BOOST_CHECK(patienceExpansions < baseExpansions);
+    BOOST_CHECK(budgetExpansions < baseExpansions);
+    BOOST_CHECK(patienceRecall >= baseRecall - 0.05f);
+    BOOST_CHECK(budgetRecall >= baseRecall - 0.05f);
+}
+
+template <typename T>
+void SearchOptionsSearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 20000, q = 200;
+    SPTAG::DimensionType m = 32;
+    int k = 10;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 100));
+
+    std::vector<std::vector<SPTAG::SizeType>> truth(q);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        std::vector<std::pair<float, SPTAG::SizeType>> dists(n);
+        for (SPTAG::SizeType j = 0; j < n; j++)
+            dists[j] = std::make_pair(SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query.data() + i * m, vec.data() + j * m, m), j);
+        std::partial_sort(dists.begin(), dists.begin() + k, dists.end());
+        for (int j = 0; j < k; j++) truth[i].push_back(dists[j].second);
+    }
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("MaxCheck", "64");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    SPTAG::SearchOptions fast, accurate;
+    fast.m_initialDynamicPivots = 8;
+    accurate.m_maxCheck = 4096;
+    accurate.m_continuousLimit = 8;
+    const SPTAG::SearchOptions* settings[] = { nullptr, &fast, &accurate };
+
+    auto search = [&](SPTAG::SizeType i, const SPTAG::SearchOptions* options, SPTAG::BasicResult* results) {
+        SPTAG::QueryResult res(query.data() + i * m, k, false, results);
+        res.Reset();
+        if (options != nullptr) res.SetSearchOptions(*options);
+        vecIndex->SearchIndex(res);
+    };
+
+    // Sequential runs give the reference results and the recall of each setting.
+    std::vector<std::vector<SPTAG::BasicResult>> expected(3 * q, std::vector<SPTAG::BasicResult>(k));
+    float recall[3];
+    for (int s = 0; s < 3; s++)
+    {
+        int hits = 0;
+        for (SPTAG::SizeType i = 0; i < q; i++)
+        {
+            search(i, settings[s], expected[s * q + i].data());
+            for (int j = 0; j < k; j++)
+                if (std::find(truth[i].begin(), truth[i].end(), expected[s * q + i][j].VID) != truth[i].end()) hits++;
+        }
+        recall[s] = (float)hits / (q * k);
+    }
+    std::cout << "recall@" << k << " default: " << recall[0] << ", fast: " << recall[1] << ", accurate: " << recall[2] << std::endl;
+    BOOST_CHECK(recall[2] > recall[0]);
+    BOOST_CHECK(recall[2] >= 0.95f);
+
+    // Interleaving the settings across threads must not change any result.
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++)
+    {
+        workers.emplace_back([&, t]() {
+            std::vector<SPTAG::BasicResult> results(k);
+            for (SPTAG::SizeType i = 0; i < q; i++)
+            {
+                int s = (i + t) % 3;
+                search(i, settings[s], results.data());
+                for (int j = 0; j < k; j++)
+                    if (results[j].VID != expected[s * q + i][j].VID) mismatches++;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    BOOST_CHECK_EQUAL(mismatches.load(), 0);
+
+    // Deleted vectors are only returned to queries that ask for them.
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->DeleteIndex(vec.data(), 1));
+    SPTAG::SearchOptions withDeleted;
+    withDeleted.m_searchDeleted = true;
+    withDeleted.m_maxCheck = 4096;
+    SPTAG::QueryResult res(vec.data(), 1, false);
+    res.SetSearchOptions(withDeleted);
+    vecIndex->SearchIndex(res);
+    BOOST_CHECK_EQUAL(res.GetResult(0)->VID, 0);
+    res.SetSearchOptions(SPTAG::SearchOptions());
+    res.Reset();
+    vecIndex->SearchIndex(res);
+    BOOST_CHECK(res.GetResult(0)->VID != 0);
+}
+
+template <typename T>
+void FilteredSearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 20000, q = 100;
+    SPTAG::DimensionType m = 32;
+    int k = 10;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 100));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("MaxCheck", "2048");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    // A broad bitmap is searched through the graph, a narrow one is scored directly, and a callback
+    // without a count falls back to the graph with the whole index as budget.
+    auto broad = std::make_shared<SPTAG::BitmapFilter>(n);
+    auto narrow = std::make_shared<SPTAG::BitmapFilter>(n);
+    for (SPTAG::SizeType i = 0; i < n; i++)
+    {
+        if (rand() % 10 < 3) broad->Set(i);
+        if (rand() % 100 == 0) narrow->Set(i);
+    }
+    auto even = std::make_shared<SPTAG::CallbackFilter>([](SPTAG::SizeType vid) { return vid % 2 == 0; });
+    std::vector<std::pair<std::string, std::shared_ptr<SPTAG::IFilter>>> filters = { { "broad", broad }, { "narrow", narrow }, { "even", even } };
+
+    for (auto& filter : filters)
+    {
+        int hits = 0;
+        std::vector<SPTAG::BasicResult> results(k);
+        for (SPTAG::SizeType i = 0; i < q; i++)
+        {
+            std::vector<std::pair<float, SPTAG::SizeType>> dists;
+            for (SPTAG::SizeType j = 0; j < n; j++)
+                if (filter.second->Accept(j)) dists.emplace_back(SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query.data() + i * m, vec.data() + j * m, m), j);
+            std::partial_sort(dists.begin(), dists.begin() + k, dists.end());
+
+            SPTAG::QueryResult res(query.data() + i * m, k, false, results.data());
+            res.Reset();
+            res.SetFilter(filter.second);
+            vecIndex->SearchIndex(res);
+            for (int j = 0; j < k; j++)
+            {
+                BOOST_CHECK(results[j].VID < 0 || filter.second->Accept(results[j].VID));
+                for (int t = 0; t < k; t++)
+                    if (results[j].VID == dists[t].second) hits++;
+            }
+        }
+        float recall = (float)hits / (q * k);
+        std::cout << "Filter " << filter.first << ": recall@" << k << " " << recall << std::endl;
+        BOOST_CHECK(recall >= (filter.first == "narrow" ? 1.0f : 0.8f));
+    }
+}
+
+template <typename T>
+void FilteredSPANNSearch()
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++)
+        for (SPTAG::DimensionType j = 0; j < m; j++) vec.push_back((T)i);
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+    std::shared_ptr<SPTAG::MetadataSet> metaset;
+    Build<T>(SPTAG::IndexAlgoType::SPANN, "L2", vecset, metaset, "testindices_filter");
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_filter", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex);
+
+    // Heads and posting entries are both filtered on their vector ids.
+    auto odd = std::make_shared<SPTAG::CallbackFilter>([](SPTAG::SizeType vid) { return vid % 2 == 1; });
+    for (SPTAG::SizeType target : { 100, 1000, 1501 })
+    {
+        SPTAG::QueryResult res(vec.data() + target * m, 4, false);
+        res.SetFilter(odd);
+        vecIndex->SearchIndex(res);
+        std::vector<SPTAG::SizeType> found;
+        for (int j = 0; j < 4; j++)
+        {
+            BOOST_CHECK(res.GetResult(j)->VID % 2 == 1);
+            found.push_back(res.GetResult(j)->VID);
+        }
+        std::sort(found.begin(), found.end());
+        // The four closest odd ids all lie within 4 of the target; for odd targets the fourth one is a tie.
+        BOOST_CHECK(std::unique(found.begin(), found.end()) == found.end());
+        for (int j = 0; j < 4; j++) BOOST_CHECK(std::abs(found[j] - target) <= 4);
+    }
+}
+
+template <typename T>
+void RangeSearch(SPTAG::IndexAlgoType algo)
+{
+    SPTAG::SizeType n = 20000, q = 50;
+    SPTAG::DimensionType m = 32;
+    int inRange = 30;
+    std::vector<T> vec, query;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100));
+    for (SPTAG::SizeType i = 0; i < q * m; i++) query.push_back((T)(rand() % 100));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", "L2");
+    vecIndex->SetParameter("NumberOfThreads", "4");
+    vecIndex->SetParameter("MaxCheck", "2048");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    auto byDist = [](const SPTAG::BasicResult& a, const SPTAG::BasicResult& b) { return a.Dist < b.Dist; };
+    int hits = 0, expected = 0;
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        std::vector<std::pair<float, SPTAG::SizeType>> dists;
+        for (SPTAG::SizeType j = 0; j < n; j++)
+            dists.emplace_back(SPTAG::COMMON::DistanceUtils::ComputeL2Distance(query.data() + i * m, vec.data() + j * m, m), j);
+        std::sort(dists.begin(), dists.end());
+        float radius = dists[inRange - 1].first;
+        std::unordered_set<SPTAG::SizeType> truth;
+        for (SPTAG::SizeType j = 0; j < n && dists[j].first <= radius; j++) truth.insert(dists[j].second);
+        expected += (int)truth.size();
+
+        std::vector<SPTAG::BasicResult> results;
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexRange(query.data() + i * m, radius, n, results));
+        BOOST_CHECK(std::is_sorted(results.begin(), results.end(), byDist));
+        std::unordered_set<SPTAG::SizeType> seen;
+        for (const SPTAG::BasicResult& res : results)
+        {
+            BOOST_CHECK(res.Dist <= radius);
+            BOOST_CHECK(seen.insert(res.VID).second);
+            if (truth.count(res.VID) > 0) hits++;
+        }
+
+        std::vector<SPTAG::BasicResult> capped;
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexRange(query.data() + i * m, radius, 5, capped));
+        BOOST_CHECK_EQUAL(capped.size(), 5);
+    }
+    float recall = (float)hits / expected;
+    std::cout << "Range search: recall " << recall << " over " << expected << " vectors in range" << std::endl;
+    BOOST_CHECK(recall >= 0.9f);
+
+    std::vector<SPTAG::BasicResult> empty;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexRange(query.data(), -1.0f, n, empty));
+    BOOST_CHECK(empty.empty());
+}
+
+template <typename T>
+void RangeSPANNSearch()
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++)
+        for (SPTAG::DimensionType j = 0; j < m; j++) vec.push_back((T)i);
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+    std::shared_ptr<SPTAG::MetadataSet> metaset;
+    Build<T>(SPTAG::IndexAlgoType::SPANN, "L2", vecset, metaset, "testindices_range");
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices_range", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex);
+
+    // Vector i is i in every dimension, so the vectors within m * 9 of vector 1000 are 997 to 1003.
+    std::vector<SPTAG::BasicResult> results;
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexRange(vec.data() + 1000 * m, (float)(m * 9), 100, results));
+    BOOST_CHECK(results.size() >= 5 && results.size() <= 7);
+    for (const SPTAG::BasicResult& res : results) BOOST_CHECK(std::abs(res.VID - 1000) <= 3);
+    BOOST_CHECK(!results.empty() && results[0].VID == 1000);
+}
+
 BOOST_AUTO_TEST_SUITE (AlgoTest)
 
 BOOST_AUTO_TEST_CASE(KDTTest)
@@ -237,6 +1006,78 @@ BOOST_AUTO_TEST_CASE(BKTTest)
     Test<float>(SPTAG::IndexAlgoType::BKT, "L2");
 }
 
+BOOST_AUTO_TEST_CASE(BKTBatchSearchTest)
+{
+    BatchSearch<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(BKTHalfPrecisionTest)
+{
+    BatchSearch<SPTAG::Float16>(SPTAG::IndexAlgoType::BKT, "L2");
+    BatchSearch<SPTAG::BFloat16>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(BKTInnerProductTest)
+{
+    InnerProductSearch<float>("true");
+    InnerProductSearch<float>("false");
+    InnerProductSearch<std::int8_t>("true");
+}
+
+BOOST_AUTO_TEST_CASE(HeapArityTest)
+{
+    HeapAritySearch<float>(SPTAG::IndexAlgoType::BKT);
+    HeapAritySearch<float>(SPTAG::IndexAlgoType::KDT);
+}
+
+BOOST_AUTO_TEST_CASE(BKTGraphReorderTest)
+{
+    GraphReorderSearch<float>();
+}
+
+BOOST_AUTO_TEST_CASE(MemoryMappedLoadTest)
+{
+    MemoryMappedSearch<float>(SPTAG::IndexAlgoType::BKT);
+    MemoryMappedSearch<float>(SPTAG::IndexAlgoType::KDT);
+}
+
+BOOST_AUTO_TEST_CASE(HugePageTest)
+{
+    HugePageSearch<float>(SPTAG::IndexAlgoType::BKT);
+    HugePageSearch<float>(SPTAG::IndexAlgoType::KDT);
+}
+
+BOOST_AUTO_TEST_CASE(BKTNumaTest)
+{
+    NumaSearch<float>();
+}
+
+BOOST_AUTO_TEST_CASE(TerminationPolicyTest)
+{
+    TerminationPolicySearch<float>(SPTAG::IndexAlgoType::BKT);
+    TerminationPolicySearch<float>(SPTAG::IndexAlgoType::KDT);
+}
+
+BOOST_AUTO_TEST_CASE(SearchOptionsTest)
+{
+    SearchOptionsSearch<float>(SPTAG::IndexAlgoType::BKT);
+    SearchOptionsSearch<float>(SPTAG::IndexAlgoType::KDT);
+}
+
+BOOST_AUTO_TEST_CASE(FilteredSearchTest)
+{
+    FilteredSearch<float>(SPTAG::IndexAlgoType::BKT);
+    FilteredSearch<float>(SPTAG::IndexAlgoType::KDT);
+    FilteredSPANNSearch<float>();
+}
+
+BOOST_AUTO_TEST_CASE(RangeSearchTest)
+{
+    RangeSearch<float>(SPTAG::IndexAlgoType::BKT);
+    RangeSearch<float>(SPTAG::IndexAlgoType::KDT);
+    RangeSPANNSearch<float>();
+}
+
 BOOST_AUTO_TEST_CASE(SPANNTest)
 {
     Test<float>(SPTAG::IndexAlgoType::SPANN, "L2");
@@ -1,7 +1,9 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <bitset>
+#include <cmath>
 #include <ctime>
 #include <thread>
 #include <vector>
@@ -49,6 +51,154 @@ void test(int high) {
     delete[] Y;
 }
 
+template<typename T>
+void test_inner_product(int high) {
+    for (SPTAG::DimensionType dimension : { 1, 7, 16, 33, 100, random<SPTAG::DimensionType>(256, 2) }) {
+        std::vector<T> X(dimension), Y(dimension);
+        double dot = 0;
+        for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+            X[i] = random<T>(high, -high);
+            Y[i] = random<T>(high, -high);
+            dot += (double)X[i] * (double)Y[i];
+        }
+        double tolerance = 1e-6 * high * high * dimension;
+        BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance(X.data(), Y.data(), dimension), tolerance);
+        BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_SSE(X.data(), Y.data(), dimension), tolerance);
+        if (SPTAG::COMMON::InstructionSet::AVX2())
+            BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_AVX(X.data(), Y.data(), dimension), tolerance);
+        if (SPTAG::COMMON::InstructionSet::AVX512())
+            BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_AVX512(X.data(), Y.data(), dimension), tolerance);
+
+        // Cosine and inner product share the dot product kernels.
+        float base = (float)SPTAG::COMMON::Utils::GetBase<T>() * SPTAG::COMMON::Utils::GetBase<T>();
+        BOOST_CHECK_CLOSE_FRACTION(base + SPTAG::COMMON::DistanceUtils::ComputeDistance(X.data(), Y.data(), dimension, SPTAG::DistCalcMethod::InnerProduct),
+            SPTAG::COMMON::DistanceUtils::ComputeDistance(X.data(), Y.data(), dimension, SPTAG::DistCalcMethod::Cosine), 1e-5);
+    }
+}
+
+template<typename T>
+void test_batch(int high) {
+    SPTAG::DimensionType dimension = random<SPTAG::DimensionType>(256, 2);
+    int count = 11;
+    std::vector<T> X(dimension), Y(count * dimension);
+    std::vector<const T*> rows(count);
+    for (SPTAG::DimensionType i = 0; i < dimension; i++) X[i] = random<T>(high, -high);
+    for (int i = 0; i < count * dimension; i++) Y[i] = random<T>(high, -high);
+    for (int i = 0; i < count; i++) rows[i] = Y.data() + i * dimension;
+
+    for (SPTAG::DistCalcMethod method : { SPTAG::DistCalcMethod::L2, SPTAG::DistCalcMethod::Cosine, SPTAG::DistCalcMethod::InnerProduct }) {
+        std::vector<float> dists(count);
+        SPTAG::COMMON::DistanceBatchCalcSelector<T>(method)(X.data(), rows.data(), count, dimension, dists.data());
+        for (int i = 0; i < count; i++) {
+            BOOST_CHECK_EQUAL(SPTAG::COMMON::DistanceUtils::ComputeDistance(X.data(), rows[i], dimension, method), dists[i]);
+        }
+    }
+}
+
+template<typename T>
+void test_fixed_dimension(int high) {
+    for (SPTAG::DimensionType dimension : { 64, 96, 128, 256, 768 }) {
+        int count = 5;
+        std::vector<T> X(dimension), Y(count * dimension);
+        std::vector<const T*> rows(count);
+        for (SPTAG::DimensionType i = 0; i < dimension; i++) X[i] = random<T>(high, -high);
+        for (int i = 0; i < count * dimension; i++) Y[i] = random<T>(high, -high);
+        for (int i = 0; i < count; i++) rows[i] = Y.data() + i * dimension;
+
+        for (SPTAG::DistCalcMethod method : { SPTAG::DistCalcMethod::L2, SPTAG::DistCalcMethod::Cosine }) {
+            auto fixed = SPTAG::COMMON::DistanceCalcSelector<T>(method, dimension);
+            std::vector<float> dists(count);
+            SPTAG::COMMON::DistanceBatchCalcSelector<T>(method, dimension)(X.data(), rows.data(), count, dimension, dists.data());
+            for (int i = 0; i < count; i++) {
+                float expected = SPTAG::COMMON::DistanceCalcSelector<T>(method)(X.data(), rows[i], dimension);
+                // Float cosine distances can cancel to near zero, so the relative bound is floored at base^2.
+                BOOST_CHECK_SMALL((double)expected - fixed(X.data(), rows[i], dimension), 1e-5 * std::max<double>(std::abs(expected), (double)high * high));
+                BOOST_CHECK_EQUAL(fixed(X.data(), rows[i], dimension), dists[i]);
+            }
+        }
+    }
+}
+
+template<typename T>
+void test_vnni(int low, int high, float base) {
+    std::vector<SPTAG::DimensionType> dimensions{ 1, 31, 64, 100, 768, random<SPTAG::DimensionType>(1024, 2) };
+    for (SPTAG::DimensionType dimension : dimensions) {
+        std::vector<T> X(dimension), Y(dimension), L(dimension, (T)low), H(dimension, (T)high);
+        for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+            X[i] = random<T>(high, low);
+            Y[i] = random<T>(high, low);
+        }
+
+        auto check = [&](SPTAG::COMMON::DistanceCalcReturn<T> l2, SPTAG::COMMON::DistanceCalcReturn<T> cosine) {
+            BOOST_CHECK_CLOSE_FRACTION(ComputeL2Distance(X.data(), Y.data(), dimension), l2(X.data(), Y.data(), dimension), 1e-5);
+            BOOST_CHECK_CLOSE_FRACTION(base - ComputeCosineDistance(X.data(), Y.data(), dimension), cosine(X.data(), Y.data(), dimension), 1e-5);
+            // Saturated inputs: the kernels accumulate in integers, so compare with the exact values.
+            BOOST_CHECK_EQUAL((float)((double)dimension * (high - low) * (high - low)), l2(L.data(), H.data(), dimension));
+            BOOST_CHECK_EQUAL((float)(base - (double)dimension * low * low), cosine(L.data(), L.data(), dimension));
+            BOOST_CHECK_EQUAL((float)(base - (double)dimension * low * high), cosine(L.data(), H.data(), dimension));
+        };
+        if (SPTAG::COMMON::InstructionSet::AVX512VNNI())
+            check(&SPTAG::COMMON::DistanceUtils::ComputeL2Distance_AVX512VNNI, &SPTAG::COMMON::DistanceUtils::ComputeCosineDistance_AVX512VNNI);
+        if (SPTAG::COMMON::InstructionSet::AVXVNNI())
+            check(&SPTAG::COMMON::DistanceUtils::ComputeL2Distance_AVXVNNI, &SPTAG::COMMON::DistanceUtils::ComputeCosineDistance_AVXVNNI);
+    }
+}
+
+template<typename T>
+void test_half_round_trip() {
+    for (std::uint32_t bits = 0; bits <= 0xFFFF; bits++) {
+        float value = T::ToFloat((std::uint16_t)bits);
+        if (value != value) continue;
+        BOOST_CHECK_EQUAL(bits, T::FromFloat(value));
+    }
+}
+
+template<typename T>
+void test_half(double tolerance) {
+    for (SPTAG::DimensionType dimension : { 1, 15, 16, 33, 64, 100, 768, random<SPTAG::DimensionType>(256, 2) }) {
+        int count = 5;
+        std::vector<T> X(dimension), Y(count * dimension);
+        std::vector<const T*> rows(count);
+        for (SPTAG::DimensionType i = 0; i < dimension; i++) X[i] = T(random<float>(1, -1));
+        for (int i = 0; i < count * dimension; i++) Y[i] = T(random<float>(1, -1));
+        for (int i = 0; i < count; i++) rows[i] = Y.data() + i * dimension;
+
+        for (int r = 0; r < count; r++) {
+            double l2 = 0, dot = 0;
+            for (SPTAG::DimensionType i = 0; i < dimension; i++) {
+                double x = (float)X[i], y = (float)rows[r][i];
+                l2 += (x - y) * (x - y);
+                dot += x * y;
+            }
+            const T* pY = rows[r];
+            BOOST_CHECK_SMALL(l2 - SPTAG::COMMON::DistanceUtils::ComputeL2Distance_SSE(X.data(), pY, dimension), tolerance * dimension);
+            BOOST_CHECK_SMALL(1 - dot - SPTAG::COMMON::DistanceUtils::ComputeCosineDistance_SSE(X.data(), pY, dimension), tolerance * dimension);
+            BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_SSE(X.data(), pY, dimension), tolerance * dimension);
+            if (SPTAG::COMMON::InstructionSet::AVX2()) {
+                BOOST_CHECK_SMALL(l2 - SPTAG::COMMON::DistanceUtils::ComputeL2Distance_AVX(X.data(), pY, dimension), tolerance * dimension);
+                BOOST_CHECK_SMALL(1 - dot - SPTAG::COMMON::DistanceUtils::ComputeCosineDistance_AVX(X.data(), pY, dimension), tolerance * dimension);
+                BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_AVX(X.data(), pY, dimension), tolerance * dimension);
+            }
+            if (SPTAG::COMMON::InstructionSet::AVX512()) {
+                BOOST_CHECK_SMALL(l2 - SPTAG::COMMON::DistanceUtils::ComputeL2Distance_AVX512(X.data(), pY, dimension), tolerance * dimension);
+                BOOST_CHECK_SMALL(1 - dot - SPTAG::COMMON::DistanceUtils::ComputeCosineDistance_AVX512(X.data(), pY, dimension), tolerance * dimension);
+                BOOST_CHECK_SMALL(-dot - SPTAG::COMMON::DistanceUtils::ComputeInnerProductDistance_AVX512(X.data(), pY, dimension), tolerance * dimension);
+            }
+        }
+
+        for (SPTAG::DistCalcMethod method : { SPTAG::DistCalcMethod::L2, SPTAG::DistCalcMethod::Cosine, SPTAG::DistCalcMethod::InnerProduct }) {
+            auto generic = SPTAG::COMMON::DistanceCalcSelector<T>(method);
+            auto fixed = SPTAG::COMMON::DistanceCalcSelector<T>(method, dimension);
+            std::vector<float> dists(count);
+            SPTAG::COMMON::DistanceBatchCalcSelector<T>(method, dimension)(X.data(), rows.data(), count, dimension, dists.data());
+            for (int i = 0; i < count; i++) {
+                BOOST_CHECK_SMALL((double)generic(X.data(), rows[i], dimension) - fixed(X.data(), rows[i], dimension), tolerance * dimension);
+                BOOST_CHECK_EQUAL(fixed(X.data(), rows[i], dimension), dists[i]);
+            }
+        }
+    }
+}
+
 template <typename T>
 void test_dist_calc_performance(
     int high, 
@@ -92,6 +242,52 @@ BOOST_AUTO_TEST_CASE(TestDistanceComputation)
     test<std::int16_t>(32767);
 }
 
+BOOST_AUTO_TEST_CASE(TestInnerProductDistanceComputation)
+{
+    test_inner_product<float>(1);
+    test_inner_product<std::int8_t>(127);
+    test_inner_product<std::uint8_t>(127);
+    test_inner_product<std::int16_t>(32767);
+}
+
+BOOST_AUTO_TEST_CASE(TestBatchDistanceComputation)
+{
+    test_batch<float>(1);
+    test_batch<std::int8_t>(127);
+    test_batch<std::uint8_t>(127);
+    test_batch<std::int16_t>(32767);
+}
+
+BOOST_AUTO_TEST_CASE(TestVNNIDistanceComputation)
+{
+    test_vnni<std::int8_t>(-128, 127, 127 * 127);
+    test_vnni<std::uint8_t>(0, 255, 255 * 255);
+}
+
+BOOST_AUTO_TEST_CASE(TestFixedDimensionDistanceComputation)
+{
+    test_fixed_dimension<float>(1);
+    test_fixed_dimension<std::int8_t>(127);
+    test_fixed_dimension<std::uint8_t>(127);
+    test_fixed_dimension<std::int16_t>(32767);
+}
+
+BOOST_AUTO_TEST_CASE(TestHalfPrecisionDistanceComputation)
+{
+    BOOST_CHECK_EQUAL(SPTAG::Float16(1.0f).m_bits, 0x3C00);
+    BOOST_CHECK_EQUAL(SPTAG::Float16(65504.0f).m_bits, 0x7BFF);
+    BOOST_CHECK_EQUAL(SPTAG::Float16(65520.0f).m_bits, 0x7C00);
+    BOOST_CHECK_EQUAL(SPTAG::Float16(5.9604645e-08f).m_bits, 0x0001);
+    BOOST_CHECK_EQUAL(SPTAG::BFloat16(1.0f).m_bits, 0x3F80);
+    BOOST_CHECK_EQUAL(SPTAG::BFloat16(1.00390625f).m_bits, 0x3F80);
+    BOOST_CHECK_EQUAL(SPTAG::BFloat16(1.01171875f).m_bits, 0x3F82);
+    test_half_round_trip<SPTAG::Float16>();
+    test_half_round_trip<SPTAG::BFloat16>();
+
+    test_half<SPTAG::Float16>(1e-5);
+    test_half<SPTAG::BFloat16>(1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(TestDistanceComputationPerformance)
 {
     std::vector<SPTAG::DimensionType> dimensions{128, 256, 512, 1024};
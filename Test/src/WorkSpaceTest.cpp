@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Test.h"
+#include "inc/Core/Common/WorkSpace.h"
+#include "inc/Core/Common/WorkSpacePool.h"
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace
+{
+    // Workspace that only records how many copies were made and whether it is rented out.
+    struct CountedWorkSpace
+    {
+        CountedWorkSpace() : m_rented(false) {}
+
+        CountedWorkSpace(CountedWorkSpace&) : m_rented(false) { s_created++; }
+
+        void Initialize(va_list&) {}
+
+        static void Reset() {}
+
+        std::atomic<bool> m_rented;
+
+        static std::atomic<int> s_created;
+    };
+
+    std::atomic<int> CountedWorkSpace::s_created(0);
+
+    class TestHashPosVector : public SPTAG::COMMON::OptHashPosVector
+    {
+    public:
+        int PoolSize() const { return m_poolSize; }
+
+        void SetEpoch(std::uint32_t epoch) { m_epoch = epoch; }
+    };
+
+    // Per-query cost of resetting the visited set and marking maxCheck nodes, with either the
+    // epoch based clear() or a wipe of both SizeType blocks as the previous implementation did.
+    double reset_cost(int maxCheck, int hashExp, bool wipe, int queries)
+    {
+        TestHashPosVector visited;
+        visited.Init(maxCheck, hashExp);
+        std::vector<SPTAG::SizeType> oldTable(2 * (visited.PoolSize() + 1));
+
+        std::mt19937 rg(0);
+        std::uniform_int_distribution<SPTAG::SizeType> dist(0, 1000000);
+        std::vector<SPTAG::SizeType> ids(maxCheck);
+        for (auto& id : ids) id = dist(rg);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int q = 0; q < queries; q++)
+        {
+            if (wipe) memset(oldTable.data(), 0, sizeof(SPTAG::SizeType) * oldTable.size());
+            visited.clear();
+            for (int i = 0; i < maxCheck; i++) visited.CheckAndSet(ids[(i + q) % maxCheck]);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000.0 / queries;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(WorkSpaceTest)
+
+BOOST_AUTO_TEST_CASE(TestOptHashPosVector)
+{
+    TestHashPosVector visited;
+    visited.Init(1024, 2);
+    BOOST_CHECK_EQUAL(visited.MaxCheck(), 2048);
+
+    for (int round = 0; round < 3; round++)
+    {
+        for (SPTAG::SizeType i = 0; i < 1000; i++) BOOST_CHECK(!visited.CheckAndSet(i * 7 + round));
+        for (SPTAG::SizeType i = 0; i < 1000; i++) BOOST_CHECK(visited.CheckAndSet(i * 7 + round));
+        visited.clear();
+    }
+
+    // Entries of the current epoch survive a resize.
+    int poolSize = visited.PoolSize();
+    SPTAG::SizeType count = 4 * (poolSize + 1);
+    for (SPTAG::SizeType i = 0; i < count; i++) visited.CheckAndSet(i);
+    BOOST_CHECK(visited.PoolSize() > poolSize);
+    for (SPTAG::SizeType i = 0; i < count; i++) BOOST_CHECK(visited.CheckAndSet(i));
+
+    // A wrapped epoch wipes the table instead of reviving stale entries.
+    visited.clear();
+    visited.SetEpoch((std::numeric_limits<std::uint32_t>::max)());
+    BOOST_CHECK(!visited.CheckAndSet(5));
+    visited.clear();
+    for (SPTAG::SizeType i = 0; i < count; i++) BOOST_CHECK(!visited.CheckAndSet(i));
+}
+
+BOOST_AUTO_TEST_CASE(TestHeapArity)
+{
+    for (int arity : { 2, 4, 8 })
+    {
+        SPTAG::COMMON::Heap<SPTAG::NodeDistPair> heap(100, arity);
+        BOOST_CHECK_EQUAL(heap.Arity(), arity);
+
+        std::mt19937 rg(arity);
+        std::uniform_real_distribution<float> dist(0, 1000);
+        std::vector<float> values;
+        for (int i = 0; i < 100; i++)
+        {
+            values.push_back(dist(rg));
+            heap.insert(SPTAG::NodeDistPair(i, values.back()));
+        }
+
+        // A full heap keeps small values and drops the one that is larger than its last level.
+        heap.insert(SPTAG::NodeDistPair(100, -1));
+        heap.insert(SPTAG::NodeDistPair(101, 2000));
+        BOOST_CHECK_EQUAL(heap.size(), 100);
+        BOOST_CHECK_EQUAL(heap.Top().node, 100);
+
+        float last = -2;
+        while (!heap.empty())
+        {
+            auto& top = heap.pop();
+            BOOST_CHECK(top.distance >= last);
+            BOOST_CHECK(top.node != 101);
+            last = top.distance;
+        }
+    }
+    BOOST_CHECK_EQUAL(SPTAG::COMMON::Heap<SPTAG::NodeDistPair>(10, 3).Arity(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkSpacePoolReuse)
+{
+    CountedWorkSpace::s_created = 0;
+    std::shared_ptr<CountedWorkSpace> outlived;
+    {
+        SPTAG::COMMON::WorkSpacePool<CountedWorkSpace> pool;
+        pool.Init(2);
+        BOOST_CHECK_EQUAL(CountedWorkSpace::s_created.load(), 2);
+
+        // A thread gets back the workspace it returned last.
+        auto first = pool.Rent();
+        pool.Return(first);
+        BOOST_CHECK(pool.Rent() == first);
+
+        auto second = pool.Rent();
+        auto third = pool.Rent();
+        BOOST_CHECK(first != second && second != third && first != third);
+        BOOST_CHECK_EQUAL(CountedWorkSpace::s_created.load(), 3);
+        pool.Return(first);
+        pool.Return(second);
+        pool.Return(third);
+
+        for (int i = 0; i < 3; i++) pool.Rent();
+        BOOST_CHECK_EQUAL(CountedWorkSpace::s_created.load(), 3);
+        outlived = pool.Rent();
+    }
+    // Rented workspaces stay valid after the pool is gone.
+    BOOST_CHECK(!outlived->m_rented.load());
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkSpacePoolThreadChurn)
+{
+    // Short-lived threads must not strand workspaces: SPANN maps each one to its own IO channel.
+    CountedWorkSpace::s_created = 0;
+    SPTAG::COMMON::WorkSpacePool<CountedWorkSpace> pool;
+    pool.Init(2);
+    for (int i = 0; i < 100; i++)
+    {
+        std::thread worker([&]() {
+            auto workSpace = pool.Rent();
+            pool.Return(workSpace);
+        });
+        worker.join();
+    }
+    BOOST_CHECK_EQUAL(CountedWorkSpace::s_created.load(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkSpacePoolConcurrent)
+{
+    const int threads = 16, rounds = 20000;
+    CountedWorkSpace::s_created = 0;
+    SPTAG::COMMON::WorkSpacePool<CountedWorkSpace> pool;
+    pool.Init(threads);
+
+    std::atomic<int> shared(0);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < rounds; i++)
+            {
+                // Hold two at times, so that workspaces also travel through the freelists.
+                auto workSpace = pool.Rent();
+                if (workSpace->m_rented.exchange(true)) shared++;
+                std::shared_ptr<CountedWorkSpace> extra;
+                if (i % 3 == 0)
+                {
+                    extra = pool.Rent();
+                    if (extra->m_rented.exchange(true)) shared++;
+                    extra->m_rented = false;
+                }
+                workSpace->m_rented = false;
+                pool.Return(workSpace);
+                if (extra != nullptr) pool.Return(extra);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "WorkSpacePool: " << (std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / ((double)threads * rounds))
+        << "ns per query with " << threads << " threads, " << CountedWorkSpace::s_created.load() << " workspaces" << std::endl;
+    BOOST_CHECK_EQUAL(shared.load(), 0);
+    BOOST_CHECK(CountedWorkSpace::s_created.load() <= 2 * threads);
+}
+
+BOOST_AUTO_TEST_CASE(TestOptHashPosVectorResetPerformance)
+{
+    for (int hashExp : { 2, 4 })
+    {
+        for (int maxCheck : { 1024, 8192 })
+        {
+            double wipe = reset_cost(maxCheck, hashExp, true, 2000);
+            double epoch = reset_cost(maxCheck, hashExp, false, 2000);
+            std::cout << "HashTableExponent: " << hashExp << ", MaxCheck: " << maxCheck
+                << ", memset reset: " << wipe << "us/query, epoch reset: " << epoch << "us/query" << std::endl;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()